@@ -27,15 +27,36 @@
 #include <GLFW/glfw3.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <queue>
+#include <thread>
 
 #include "Shader.h"
 #include "Input.h"
 #include "Bv_Settings.h"
+#include "Bv_Shaders.h"
+#include "Chunks.h"
+#include "Lod.h"
+#include "Point_octree.h"
+#include "Frame_profiler.h"
+#include "Offscreen.h"
+#include "Oit.h"
+#include "Frame_capture.h"
+#include "Program_cache.h"
+#include "Bvh.h"
+#include "Direct_mesh.h"
+#include "Scene_stream.h"
 #include "math.h"
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
-
 namespace CGAL::GLFW {
   enum RenderMode{ // rendering mode
       DRAW_ALL=-1, // draw all
@@ -56,14 +77,61 @@ namespace CGAL::GLFW {
 
   const int windowSamples = WINDOW_SAMPLES;
 
+  // Camera, clipping plane and display state of one image of Basic_Viewer::render_views,
+  // Basic_Viewer::current_view() gives the state of the viewer
+  struct Viewer_view {
+    Eigen::Vector3f position {0, 0, -5};
+    Eigen::Vector3f forward {0, 0, 1};
+    Eigen::Matrix4f scene_rotation = Eigen::Matrix4f::Identity();
+    CAM_MODE cam_mode = PERSPECTIVE;
+    float orth_zoom = 1.f;
+
+    ClippingMode clipping_mode = CLIPPING_PLANE_OFF;
+    Eigen::Matrix4f clipping_matrix = Eigen::Matrix4f::Identity();
+    bool clipping_plane_rendering = true;
+
+    bool draw_vertices = true;
+    bool draw_edges = true;
+    bool draw_rays = true;
+    bool draw_lines = true;
+    bool draw_faces = true;
+
+    std::string path; // image file (PNG, QOI, PPM, PAM or RGBA, see Image_encoder), empty to get the pixels back
+  };
+
+  // Element of the scene under the cursor, see Basic_Viewer::pick
+  struct Pick_result {
+    int gsEnum = -1;             // position array of the element (Graphics_scene::POS_*), -1 if nothing is picked
+    std::size_t index = 0;       // point, segment or triangle in this array
+    Eigen::Vector3f point {0, 0, 0}; // model space: hit point of a triangle, point of a vertex or an edge closest to the cursor
+    float pixel_distance = 0.f;  // from the cursor to the projection of point
+
+    explicit operator bool() const { return gsEnum >= 0; }
+  };
+
   void glfwErrorCallback(int error, const char *description);
   inline void draw_graphics_scene(const Graphics_scene &graphics_scene,
                                     const char *title = "CGAL Basic Viewer");
+  inline void draw_graphics_scene(const Graphics_scene &graphics_scene,
+                                    const Lod_mesh &lod,
+                                    const char *title = "CGAL Basic Viewer");
+  inline void draw_graphics_scene(const Graphics_scene &graphics_scene,
+                                    const Lod_mesh &lod,
+                                    const Direct_mesh &direct,
+                                    const char *title = "CGAL Basic Viewer");
 
   class Basic_Viewer : public Input {
   public: 
     typedef CGAL::Exact_predicates_inexact_constructions_kernel Local_kernel;
 
+    // Called each frame for each non empty position array (Graphics_scene::POS_*) in dynamic geometry mode,
+    // positions points to nb_elements*3 floats that are read by the GPU for this frame.
+    typedef std::function<void(int gsEnum, float* positions, std::size_t nb_elements)> Dynamic_positions_callback;
+    // Called with the element under the cursor each time the cursor moves
+    typedef std::function<void(const Pick_result& picked)> Pick_callback;
+    // Adds the faces of the scene that were left out for the levels of detail, see lod_fallback_faces
+    typedef std::function<void()> Faces_callback;
+
     typedef Eigen::Matrix4f mat4f;
     typedef Eigen::Vector4f vec4f;
     typedef Eigen::Vector3f vec3f;
@@ -82,46 +150,144 @@ namespace CGAL::GLFW {
                     bool draw_lines = true);    
     
     void show();
+    // The image format is chosen from the extension of the path (see Image_encoder)
     void make_screenshot(const std::string& pngpath);
+    // Renders all the views with one offscreen context: the programs are compiled and the scene is uploaded once,
+    // the readback of a view overlaps the rendering of the next ones. Views with a path are written by the
+    // capture threads, the pixels of the others are stored at their index in images (if not nullptr).
+    // The state of the viewer is restored afterwards.
+    void render_views(const std::vector<Viewer_view>& views, std::vector<Captured_frame>* images = nullptr);
+    Viewer_view current_view() const;
+    // Renders an image of any size offscreen, tile by tile, each tile being a part of the view frustum
+    // of the camera (with the aspect ratio of the image). Each pixel averages supersampling^2 samples.
+    // The image is streamed to the file by bands of tiles, it is never held in memory as a whole.
+    void make_poster(const std::string& path, int width, int height, int supersampling = 1);
+
+    // Schedules a new frame, frames are only drawn when something changed (the setters below call it).
+    // Can be called from any thread.
+    void redraw();
 
     /***** Getter & Setter ****/
     
     // Setter Section
-    inline void position(const vec3f& pos) { m_cam_position = pos; }
-    inline void forward(const vec3f& dir) { m_cam_forward = dir; }
+    inline void position(const vec3f& pos) { m_cam_position = pos; redraw(); }
+    inline void forward(const vec3f& dir) { m_cam_forward = dir; redraw(); }
     inline void set_scene(const Graphics_scene* scene) { 
       m_scene = scene;
       m_is_scene_loaded = false;
+      redraw();
     }
     inline void window_size(const vec2f& size){
       window_size_callback(m_window, size.x(), size.y());
     }
 
-    inline void vertices_mono_color(const CGAL::IO::Color& c) { m_vertices_mono_color = c; }
-    inline void edges_mono_color(const CGAL::IO::Color& c) { m_edges_mono_color = c; }
-    inline void rays_mono_color(const CGAL::IO::Color& c) { m_rays_mono_color = c; }
-    inline void lines_mono_color(const CGAL::IO::Color& c) { m_lines_mono_color = c; }
-    inline void faces_mono_color(const CGAL::IO::Color& c) { m_faces_mono_color = c; }
-
-    inline void size_points(const float size) { m_size_points = size; }
-    inline void size_edges(const float size) { m_size_edges = size; }
-    inline void size_rays(const float size) { m_size_rays = size; }
-    inline void size_lines(const float size) { m_size_lines = size; }
-
-    inline void light_position(const vec4f& pos) { m_light_position = pos; }
-    inline void light_ambient(const vec4f& color) { m_ambient = color; }
-    inline void light_diffuse(const vec4f& color) { m_diffuse = color; }
-    inline void light_specular(const vec4f& color) { m_specular = color; }
-    inline void light_shininess(const float shininess) { m_shininess = shininess; }
-
-    inline void draw_vertices(bool b) { m_draw_vertices = b; }
-    inline void draw_edges(bool b) { m_draw_edges = b; }
-    inline void draw_rays(bool b) { m_draw_rays = b; }
-    inline void draw_lines(bool b) { m_draw_lines = b; }
-    inline void draw_faces(bool b) { m_draw_faces = b; }
-    inline void use_mono_color(bool b) { m_use_mono_color = b; }
-    inline void inverse_normal(bool b) { m_inverse_normal = b; }
-    inline void flat_shading(bool b) { m_flat_shading = b; }
+    inline void vertices_mono_color(const CGAL::IO::Color& c) { m_vertices_mono_color = c; redraw(); }
+    inline void edges_mono_color(const CGAL::IO::Color& c) { m_edges_mono_color = c; redraw(); }
+    inline void rays_mono_color(const CGAL::IO::Color& c) { m_rays_mono_color = c; redraw(); }
+    inline void lines_mono_color(const CGAL::IO::Color& c) { m_lines_mono_color = c; redraw(); }
+    inline void faces_mono_color(const CGAL::IO::Color& c) { m_faces_mono_color = c; redraw(); }
+
+    inline void size_points(const float size) { m_size_points = size; redraw(); }
+    inline void size_edges(const float size) { m_size_edges = size; redraw(); }
+    inline void size_rays(const float size) { m_size_rays = size; redraw(); }
+    inline void size_lines(const float size) { m_size_lines = size; redraw(); }
+
+    inline void light_position(const vec4f& pos) { m_light_position = pos; redraw(); }
+    inline void light_ambient(const vec4f& color) { m_ambient = color; redraw(); }
+    inline void light_diffuse(const vec4f& color) { m_diffuse = color; redraw(); }
+    inline void light_specular(const vec4f& color) { m_specular = color; redraw(); }
+    inline void light_shininess(const float shininess) { m_shininess = shininess; redraw(); }
+
+    inline void draw_vertices(bool b) { m_draw_vertices = b; redraw(); }
+    inline void draw_edges(bool b) { m_draw_edges = b; redraw(); }
+    inline void draw_rays(bool b) { m_draw_rays = b; redraw(); }
+    inline void draw_lines(bool b) { m_draw_lines = b; redraw(); }
+    inline void draw_faces(bool b) { m_draw_faces = b; redraw(); }
+    inline void use_mono_color(bool b) { m_use_mono_color = b; redraw(); }
+    inline void inverse_normal(bool b) { m_inverse_normal = b; redraw(); }
+    inline void flat_shading(bool b) { 
+      m_flat_shading = b; 
+      if (!use_gpu_normals()) { update_normal_arrays(); }
+      redraw();
+    }
+    inline void interleaved_layout(bool b) { 
+      m_interleaved_layout = b; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    inline void indexed_faces(bool b) { 
+      m_indexed_faces = b; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    inline void compact_vertices(bool b) { 
+      m_compact_vertices = b; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    inline void weighted_blended_oit(bool b) { m_weighted_blended_oit = b; redraw(); }
+    // Programs are built when a context is created (show, screenshots), see Program_builder
+    inline void shader_cache(bool b) { m_shader_cache = b; }
+    inline void shader_cache_directory(const std::string& directory) { m_shader_cache_directory = directory; }
+    inline void frustum_culling(bool b) { 
+      m_frustum_culling = b; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    // Faces are drawn from the levels of detail of lod instead of the face arrays of the scene
+    // (OpenGL 4.3 only). lod must outlive the viewer, nullptr to disable.
+    inline void lod_mesh(const Lod_mesh* lod) { 
+      m_lod = lod; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    inline void lod_pixel_error(float error) { m_lod_pixel_error = error; redraw(); }
+    // Called once, between two frames, if the faces are drawn from the scene while its face arrays were left
+    // empty for the levels of detail (they are not drawn without OpenGL 4.3 nor in dynamic geometry mode).
+    // It adds the faces to the scene of the viewer. Faces are only picked once they are in the scene.
+    inline void lod_fallback_faces(Faces_callback callback) { 
+      m_lod_fallback_faces = std::move(callback); 
+      redraw();
+    }
+    // Faces written by mesh straight into the GPU buffers, drawn along with the faces of the scene (unless the
+    // levels of detail are drawn). They are not chunked nor picked, and vertices are not compact while it is
+    // drawn. mesh must outlive the viewer, nullptr to disable.
+    inline void direct_mesh(const Direct_mesh* mesh) { 
+      m_direct_mesh = mesh; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    // The updates of stream are applied to scene, which becomes the scene of the viewer, between two frames.
+    // A replacement scene becomes the scene of the viewer instead, scene is then cleared.
+    // Until the stream is finished, arrays are uploaded in separate buffers (neither chunked, welded nor
+    // compact) where only the appended elements are uploaded, and the camera is placed in front of the
+    // bounding box as long as it is not moved. stream and scene must outlive the viewer.
+    void scene_stream(Scene_stream* stream, Graphics_scene* scene);
+    inline void point_octree(bool b) { 
+      m_point_octree = b; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
+    inline void point_budget(std::size_t budget) { m_point_budget = budget; redraw(); }
+    inline void max_frame_rate(double fps) { m_max_frame_rate = fps; }
+    void vsync(bool b);
+    inline void profiling(bool b) { m_profiler.enable(b); }
+    // Dumps the profiler statistics every period seconds (0 to stop), to the CSV file csvPath if not empty,
+    // to stdout otherwise
+    void profiling_report(double period, const std::string& csvPath = "");
+    // Records the drawn frames: a Y4M stream if path ends with .y4m, images otherwise, path being then
+    // a pattern of the frame number (e.g. "frames/frame_%05d.png"): one %d or %0Nd, %% for a percent sign.
+    // With fps > 0 frames are drawn continuously and recorded at this rate, otherwise every drawn frame is recorded.
+    // Must be called from the thread of show().
+    void start_recording(const std::string& path, double fps = RECORD_FRAME_RATE);
+    void stop_recording();
+    // 0 (stored) to 9, set before any capture
+    inline void png_compression_level(int level) { m_frame_writer.encoder().png_level(level); }
+    inline void multi_draw_indirect(bool b) { 
+      m_multi_draw_indirect = b; 
+      m_are_buffers_initialized = false;
+      redraw();
+    }
     
     // Getter section
     inline vec3f position() const { return m_cam_position; }
@@ -152,33 +318,232 @@ namespace CGAL::GLFW {
     inline bool use_mono_color() const { return m_use_mono_color; }
     inline bool inverse_normal() const { return m_inverse_normal; }
     inline bool flat_shading()   const { return m_flat_shading; }
+    inline bool interleaved_layout() const { return m_interleaved_layout; }
+    inline bool indexed_faces() const { return m_indexed_faces; }
+    inline bool compact_vertices() const { return m_compact_vertices; }
+    inline bool frustum_culling() const { return m_frustum_culling; }
+    inline const Lod_mesh* lod_mesh() const { return m_lod; }
+    inline const Direct_mesh* direct_mesh() const { return m_direct_mesh; }
+    inline bool is_streaming() const { return m_scene_stream != nullptr; }
+    inline float lod_pixel_error() const { return m_lod_pixel_error; }
+    inline bool point_octree() const { return m_point_octree; }
+    inline std::size_t point_budget() const { return m_point_budget; }
+    inline double max_frame_rate() const { return m_max_frame_rate; }
+    inline bool vsync() const { return m_vsync; }
+    inline bool profiling() const { return m_profiler.enabled(); }
+    inline const Frame_profiler& profiler() const { return m_profiler; }
+    inline bool multi_draw_indirect() const { return m_multi_draw_indirect; }
+    inline bool shader_cache() const { return m_shader_cache; }
+    inline const std::string& shader_cache_directory() const { return m_shader_cache_directory; }
+    inline bool is_recording() const { return m_recording; }
+    inline int png_compression_level() const { return m_frame_writer.encoder().png_level(); }
 
     inline bool clipping_plane_enable() const { return m_use_clipping_plane != CLIPPING_PLANE_OFF; }
     inline bool is_orthograpic() const { return m_cam_mode == ORTHOGRAPHIC; }
 
     CGAL::Plane_3<Local_kernel> clipping_plane() const;
+
+    // Clip planes (a, b, c, d) in model space, applied to every pass on top of the clipping plane:
+    // the points where ax + by + cz + d < 0 are not drawn. OpenGL 4.3 only, the clip box and the
+    // clip planes share GL_MAX_CLIP_DISTANCES - 1 hardware clip distances, extra planes are ignored.
+    inline void clip_planes(const std::vector<vec4f>& planes) { m_clip_planes = planes; redraw(); }
+    inline const std::vector<vec4f>& clip_planes() const { return m_clip_planes; }
+    // Oriented clip box, image of the cube [-1, 1]^3 by transform: the points outside are not drawn
+    inline void clip_box(const mat4f& transform) { 
+      m_clip_box = transform; 
+      m_use_clip_box = true;
+      redraw();
+    }
+    inline void disable_clip_box() { m_use_clip_box = false; redraw(); }
+    inline bool has_clip_box() const { return m_use_clip_box; }
+
+    // Dynamic geometry: positions are streamed every frame through a ring of persistently mapped
+    // buffers (regular uploads if glBufferStorage is not available). Without callback, positions are
+    // copied from the scene. Faces are not indexed and attributes not interleaved in this mode.
+    void dynamic_geometry(bool b, Dynamic_positions_callback callback = {});
+    inline bool dynamic_geometry() const { return m_dynamic_geometry; }
+
+    // Notify the viewer that an array of the scene (Graphics_scene::POS_MONO_POINTS, ...) was modified.
+    // Only the modified elements [first, first+count) are uploaded again at the next frame, in place when chunked
+    // or merged with the other elements of their category. Welded faces are all welded again, and moved points
+    // of a point octree build it again.
+    void update_scene_array(int gsEnum);
+    void update_scene_array(int gsEnum, std::size_t first, std::size_t count);
+
+    // Element drawn under the cursor: a vertex, else an edge within pickRadius of the cursor, else the nearest
+    // face, on the drawn side of the clipping plane and of the clip planes. The cursor and the radius are in screen
+    // coordinates (the ones of get_cursor), not in pixels of the framebuffer. Rays and lines are not picked, nor the 
+    // positions given by a dynamic geometry callback. The BVHs of the position arrays are built when the scene is
+    // loaded with picking(true), else at the first pick, and refit or rebuilt after update_scene_array. The pick
+    // callback does not wait for them: they are built in the background and nothing is picked until they are ready.
+    Pick_result pick();
+    Pick_result pick(const vec2f& cursor, float pickRadius);
+    inline void picking(bool b) { m_picking = b; }
+    inline bool picking() const { return m_picking; }
+    inline void pick_radius(float r) { m_pick_radius = r; }
+    inline float pick_radius() const { return m_pick_radius; }
+    inline void pick_callback(Pick_callback callback) { m_pick_callback = std::move(callback); }
     
   private:
     static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
     static void cursor_callback(GLFWwindow* window, double xpos, double ypo);
     static void mouse_btn_callback(GLFWwindow* window, int button, int action, int mods);
     static void window_size_callback(GLFWwindow* window, int width, int height);
+    static void window_refresh_callback(GLFWwindow* window);
     static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
   
     static GLFWwindow* create_window (int width, int height, const char *title, bool hidden = false);
     static void error_callback (int error, const char *description);
 
+    struct Vertex_attribute { int location; int gsEnum; };
+
+    // Visible part of a VAO
+    struct Draw_range {
+      std::size_t first; // in vertices, or in indices for indexed VAOs
+      std::size_t count;
+      float spacing;     // point spacing of octree nodes, 0 otherwise
+    };
+
+    // std140 layout of the Frame_uniforms block (Bv_Shaders.h), followed by MAX_CLIP_DISTANCES clip planes
+    struct Frame_uniforms {
+      float mvp_matrix[16];
+      float mv_matrix[16];
+      float clipping_matrix[16];
+      float light_pos[4];
+      float light_diff[4];
+      float light_spec[4];
+      float light_amb[4];
+      float bbox_min[3];
+      float spec_power;
+      float bbox_extent[3];
+      float flat_shading;
+      float normal_sign;
+      float point_size;
+      float pixels_per_unit;
+      float rendering_transparency;
+      std::int32_t nb_clip_distances;
+      std::int32_t padding[3];
+    };
+    static_assert(sizeof(Frame_uniforms) == 320, "std140 offset of clip_planes");
+
+    // Locations of the uniforms set per draw
+    struct Draw_uniforms {
+      GLint rendering_mode = -1;
+      GLint mono_color = -1;
+    };
+
+    // Layouts read by glMultiDrawArraysIndirect and glMultiDrawElementsIndirect
+    struct Draw_arrays_command { GLuint count, instance_count, first, base_instance; };
+    struct Draw_elements_command { GLuint count, instance_count, first_index; GLint base_vertex; GLuint base_instance; };
+
+    struct Array_state {
+      std::size_t version = 0;          // incremented by each update of the array
+      std::size_t uploaded_version = 0; // version in the GPU buffers
+      std::size_t uploaded_size = 0;    // size in bytes at the last upload
+      std::size_t dirty_begin = 0;      // byte range modified since the last upload
+      std::size_t dirty_end = 0;
+    };
+
+    bool is_array_dirty(int gsEnum) const;
+    bool has_dirty_arrays() const;
+    bool is_any_dirty(std::initializer_list<Vertex_attribute> attributes) const;
+    std::pair<std::size_t, std::size_t> dirty_bytes(int gsEnum) const;
+    std::pair<std::size_t, std::size_t> dirty_vertices(std::initializer_list<Vertex_attribute> attributes) const;
+    std::pair<std::size_t, std::size_t> packed_range(int vao, std::pair<std::size_t, std::size_t> vertices) const;
+    void clear_dirty_arrays();
+    void update_normal_arrays();
+    // Same as update_scene_array, without scheduling a frame (used while a frame is drawn)
+    void mark_array_dirty(int gsEnum);
+    void mark_array_dirty(int gsEnum, std::size_t first, std::size_t count);
+
+    void query_gl_features();
     void compile_shaders();
     void load_buffer(int i, int location, int gsEnum, int dataCount);
     void load_buffer(int i, int location, const std::vector<float>& vector, int dataCount);
+    void upload_buffer(int i, GLenum target, std::size_t total, std::size_t offset, std::size_t size, const void* data);
+    std::size_t interleave(std::initializer_list<Vertex_attribute> attributes, std::vector<char>& array, 
+                           const std::vector<std::uint32_t>& order,
+                           std::size_t first = 0, std::size_t last = std::numeric_limits<std::size_t>::max()) const;
+    void pack_vertices(std::initializer_list<Vertex_attribute> attributes, const float* const* sources,
+                       const std::vector<std::uint32_t>& order, std::size_t first, std::size_t last, 
+                       std::vector<char>& array) const;
+    void set_interleaved_attributes(std::initializer_list<Vertex_attribute> attributes);
+    void load_interleaved_buffer(int i, int vao, std::initializer_list<Vertex_attribute> attributes, bool reordered);
+    bool update_chunks(int vao, int gsEnum);
+    const std::vector<std::uint32_t>& vertex_order(int vao) const;
+    const std::vector<std::uint32_t>& inverse_vertex_order(int vao) const;
+    void load_vertices(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> attributes);
+    std::size_t weld_vertices(std::vector<char>& array, std::size_t offset, std::size_t nbVertices, std::size_t stride,
+                              std::vector<std::uint32_t>& indices) const;
+    void upload_indices(int i, int vao, const std::vector<std::uint32_t>& indices, std::size_t nbVertices);
+    void load_indexed_faces(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> attributes);
+    void load_faces(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> attributes);
+    void load_category(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> mono,
+                       std::initializer_list<Vertex_attribute> colored);
+    void load_merged_category(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> mono,
+                              std::initializer_list<Vertex_attribute> colored);
+    void set_draw_params_attribute(bool enabled);
+    void load_lod();
+    void load_direct_mesh();
+    void update_scene_stream();
+    void fit_camera();
     void init_buffers();
     void load_scene();
+    bool update_pick_bvhs(bool wait = true);
+    Pick_result pick(const vec2f& cursor, float pickRadius, bool wait);
+
+    // Compact vertices and chunks are always interleaved
+    inline bool use_compact_vertices() const { 
+      return m_compact_vertices && m_is_opengl_4_3 && !m_dynamic_geometry && !use_direct_mesh() && !is_streaming(); 
+    }
+    inline bool use_chunks() const { return m_frustum_culling && !m_dynamic_geometry && !is_streaming(); }
+    // Appended elements are only uploaded in separate buffers
+    inline bool use_interleaved_layout() const { 
+      return (m_interleaved_layout || use_compact_vertices() || use_chunks()) && !m_dynamic_geometry && !is_streaming(); 
+    }
+    inline bool use_oit() const { 
+      return m_weighted_blended_oit && m_is_opengl_4_3 && m_use_clipping_plane == CLIPPING_PLANE_SOLID_HALF_TRANSPARENT_HALF; 
+    }
+    inline bool use_indexed_faces() const { return m_indexed_faces && !m_dynamic_geometry && !is_streaming(); }
+    inline bool is_indexed(int vao) const { return use_indexed_faces() && (vao == VAO_MONO_FACES || vao == VAO_COLORED_FACES); }
+    // Merged categories are packed like their colored VAO, which needs the interleaved layout
+    inline bool use_multi_draw_indirect() const { 
+      return m_multi_draw_indirect && m_is_opengl_4_3 && use_interleaved_layout(); 
+    }
+    // Levels of detail rely on the flat normals computed in the face shader
+    inline bool use_lod() const { return m_lod != nullptr && !m_lod->empty() && use_gpu_normals() && !m_dynamic_geometry; }
+    // The direct mesh has float vertices, drawn with programs compiled without compact vertices
+    inline bool use_direct_mesh() const { return m_direct_mesh != nullptr && m_direct_mesh->nb_triangles > 0 && !use_lod(); }
+    // Octree points are reordered, like chunks they need the interleaved layout
+    inline bool use_point_octree(int gsEnum) const { 
+      return m_point_octree && use_interleaved_layout() && m_scene->number_of_elements(gsEnum) >= POINT_OCTREE_MIN_POINTS; 
+    }
+
+    // Flat normals and normal inversion are done in the face shader, only smooth normals are uploaded.
+    // The compatibility shaders need the flat normal arrays and normals reversed on the CPU.
+    inline bool use_gpu_normals() const { return m_is_opengl_4_3; }
+    inline bool use_flat_normal_arrays() const { return m_flat_shading && !use_gpu_normals(); }
+
+    std::size_t attribute_size(int gsEnum) const;
+    std::size_t vertex_size(std::initializer_list<Vertex_attribute> attributes) const;
+    void pack_attribute(int gsEnum, const float* src, char* dst) const;
+    bool update_quantization_box();
+
+    void allocate_dynamic_buffer(int gsEnum, std::size_t capacity);
+    void update_dynamic_geometry();
+    void end_dynamic_frame();
 
     void update_uniforms();
+    void update_frustum();
+    bool is_box_visible(const Eigen::AlignedBox3f& box) const;
+    float projection_scale(const Eigen::AlignedBox3f& box) const;
 
     void set_face_uniforms();
     void set_pl_uniforms();
-    void set_clipping_uniforms();
+    void update_frame_uniforms();
+    void update_clip_distances();
+    void enable_clip_distances(RenderMode mode);
+    void disable_clip_distances();
 
     void render_scene();
     void draw_faces();
@@ -186,6 +551,20 @@ namespace CGAL::GLFW {
     void draw_lines();
     
     void draw_faces_(RenderMode mode);
+    void draw_category(int vao, GLenum mode, vec4f color);
+    void draw_vao(int vao, GLenum mode, int gsEnum);
+    void add_draw_range(std::size_t first, std::size_t count, float spacing);
+    void collect_ranges(int vao, int gsEnum);
+    void collect_point_octree(int vao);
+    void draw_lod_faces();
+    void draw_direct_mesh();
+    void draw_lod_chunks(const std::vector<Lod_chunk>& chunks, float colorSource);
+
+    void begin_draw_commands();
+    GLuint add_draw_params(float colorSource, float spacing);
+    void add_draw_command(int vao, const Draw_range& range, float colorSource);
+    void submit_draw_commands(GLenum mode, GLenum indexType);
+    void stream_buffer(GLenum target, GLuint buffer, std::size_t& capacity, std::size_t offset, std::size_t size, const void* data);
     void draw_vertices(RenderMode mode);
     void draw_edges(RenderMode mode);
 
@@ -217,14 +596,26 @@ namespace CGAL::GLFW {
 
     void zoom(float z);
     void fullscreen();
-    void screenshot(const std::string& pngpath);
+    void screenshot(const std::string& pngpath, Captured_frame* image = nullptr);
+    void apply_view(const Viewer_view& view);
+    mat4f tile_projection(const mat4f& projection, const vec2i& imageSize, const vec2i& min, const vec2i& max) const;
+    void capture_frame();
+    void finish_captures();
 
     void print_help();
 
+    // Frames are drawn continuously while a hold action (camera or clipping plane move) runs
+    // and while recording at a fixed frame rate
+    inline bool is_animating() const { 
+      return m_dynamic_geometry || has_started_actions() || (m_recording && m_record_rate > 0); 
+    }
+    void wait_next_frame();
+    void report_profiling();
+
     vec4f color_to_vec4(const CGAL::IO::Color& c) const;
 
   private:
-    GLFWwindow *m_window;
+    GLFWwindow *m_window = nullptr;
     const Graphics_scene *m_scene;
     const char *m_title;
     bool m_draw_vertices;
@@ -238,6 +629,11 @@ namespace CGAL::GLFW {
     bool m_flat_shading = true;
     bool m_use_mono_color;
     bool m_inverse_normal;
+    bool m_interleaved_layout = INTERLEAVED_VERTEX_LAYOUT; // one interleaved buffer per VAO instead of one buffer per attribute
+    bool m_indexed_faces = INDEXED_FACES; // welded vertices + element buffer for faces
+    bool m_compact_vertices = COMPACT_VERTICES; // quantized positions, octahedron normals, 8-bit colors
+    bool m_compiled_compact_vertices = false; // variant of the compiled programs
+    bool m_frustum_culling = FRUSTUM_CULLING; // draw only the chunks intersecting the view frustum
 
     float m_size_points = SIZE_POINTS;
     float m_size_edges = SIZE_EDGES;
@@ -259,11 +655,27 @@ namespace CGAL::GLFW {
     vec4f m_clip_plane {0, 0, 1, 0};
     vec4f m_point_plane {0, 0, 0, 1};
 
+    std::vector<vec4f> m_clip_planes;
+    mat4f m_clip_box = mat4f::Identity();
+    bool m_use_clip_box = false;
+    int m_max_clip_distances = 8;          // GL_MAX_CLIP_DISTANCES
+    std::vector<vec4f> m_clip_distances;   // planes of the hardware clip distances, the clipping plane first
+    std::vector<vec4f> m_culling_planes;   // clip distances enabled for the current pass, inside is positive
+
     mat4f m_model_view;
     mat4f m_mvp;
     bool m_is_opengl_4_3 = false;
+    bool m_has_buffer_storage = false;
 
     Shader m_pl_shader, m_face_shader, m_plane_shader;
+    Shader m_oit_composite_shader, m_copy_shader;
+    Draw_uniforms m_face_uniforms, m_pl_uniforms;
+    bool m_shader_cache = SHADER_CACHE;
+    std::string m_shader_cache_directory = SHADER_CACHE_DIRECTORY;
+
+    GLuint m_frame_ubo = 0;
+    std::vector<unsigned char> m_frame_block;          // Frame_uniforms and the clip planes
+    std::vector<unsigned char> m_uploaded_frame_block; // content of m_frame_ubo, empty after init_buffers
     
     /******* CAMERA ******/  
     
@@ -295,6 +707,9 @@ namespace CGAL::GLFW {
     
     bool m_clipping_plane_rendering = true; // will be toggled when alt+c is pressed, which is used for indicating whether or not to render the clipping plane ;
     float m_clipping_plane_rendering_transparency = CLIPPING_PLANE_RENDERING_TRANSPARENCY; // to what extent the transparent part should be rendered;
+    bool m_weighted_blended_oit = WEIGHTED_BLENDED_OIT;
+    bool m_oit_active = false; // the current frame is drawn in m_oit_framebuffer
+    Oit_framebuffer m_oit_framebuffer;
     float m_clipping_plane_move_speed = CLIPPING_PLANE_MOVE_SPEED;
     float m_clipping_plane_rot_speed = CLIPPING_PLANE_ROT_SPEED;
 
@@ -317,7 +732,7 @@ namespace CGAL::GLFW {
       MOUSE_ROTATE, MOUSE_TRANSLATE,
       UP, LEFT, RIGHT, DOWN, FORWARD, BACKWARDS, 
       SWITCH_CAM_MODE, SWITCH_CAM_ROTATION,
-      FULLSCREEN, SCREENSHOT,
+      FULLSCREEN, SCREENSHOT, RECORD,
       INC_ZOOM, DEC_ZOOM,
       INC_MOVE_SPEED_D1, INC_MOVE_SPEED_1,
       DEC_MOVE_SPEED_D1, DEC_MOVE_SPEED_1,
@@ -351,6 +766,8 @@ namespace CGAL::GLFW {
       VAO_COLORED_LINES,
       VAO_MONO_FACES,
       VAO_COLORED_FACES,
+      VAO_LOD_FACES,
+      VAO_DIRECT_FACES,
       VAO_CLIPPING_PLANE,
       NB_VAO_BUFFERS
     };
@@ -358,8 +775,150 @@ namespace CGAL::GLFW {
     GLuint m_vao[NB_VAO_BUFFERS];
 
     static const unsigned int NB_GL_BUFFERS=(Graphics_scene::END_POS-Graphics_scene::BEGIN_POS)+
-      (Graphics_scene::END_COLOR-Graphics_scene::BEGIN_COLOR)+3; // +2 for normals (mono and color), +1 for clipping plane
+      (Graphics_scene::END_COLOR-Graphics_scene::BEGIN_COLOR)+7; // +2 for normals (mono and color), +2 for lod, +2 for the direct mesh, +1 for clipping plane
 
     GLuint m_buffers[NB_GL_BUFFERS]; // +1 for the vbo buffer of clipping plane
+    std::size_t m_buffer_capacity[NB_GL_BUFFERS] = {}; // allocated size in bytes of each buffer
+
+    static const unsigned int DIRECT_VERTEX_BUFFER = NB_GL_BUFFERS - 5;
+    static const unsigned int DIRECT_INDEX_BUFFER = NB_GL_BUFFERS - 4;
+    static const unsigned int LOD_VERTEX_BUFFER = NB_GL_BUFFERS - 3;
+    static const unsigned int LOD_INDEX_BUFFER = NB_GL_BUFFERS - 2;
+    static const unsigned int CLIPPING_PLANE_BUFFER = NB_GL_BUFFERS - 1;
+
+    Array_state m_array_states[Graphics_scene::LAST_INDEX];
+
+    /***************PICKING****************/
+
+    struct Pick_bvh {
+      Bvh bvh;
+      const Graphics_scene* scene = nullptr; // scene, array version and size of the last build or refit
+      std::size_t version = 0;
+      std::size_t size = 0;
+    };
+
+    bool m_picking = PICKING;
+    float m_pick_radius = PICK_RADIUS;
+    Pick_callback m_pick_callback;
+    Pick_bvh m_pick_bvhs[Graphics_scene::END_POS]; // rays and lines stay empty
+
+    // BVH built in the background from a copy of its positions, kept if its array did not change meanwhile
+    struct Pick_build {
+      int gsEnum;
+      int primitiveSize;
+      std::vector<float> positions;
+      Pick_bvh target;
+    };
+    std::future<std::vector<Pick_build>> m_pick_builds;
+
+    /***************DYNAMIC GEOMETRY****************/
+
+    bool m_dynamic_geometry = false;
+    Dynamic_positions_callback m_dynamic_callback;
+
+    GLuint m_dynamic_buffers[Graphics_scene::END_POS];          // one position ring per POS_* array
+    float* m_dynamic_mapped[Graphics_scene::END_POS];           // persistent mapping, nullptr for the fallback path
+    std::size_t m_dynamic_capacity[Graphics_scene::END_POS];    // positions per ring segment
+    GLsync m_dynamic_fences[DYNAMIC_RING_SIZE];
+    unsigned int m_dynamic_segment = 0;
+    std::vector<float> m_dynamic_staging; // written by the callback when buffers cannot be mapped
+
+    std::vector<char> m_interleaved_array; // staging array reused by load_interleaved_buffer
+
+    vec3f m_quantization_min {0, 0, 0};    // bounding box of the compact positions
+    vec3f m_quantization_extent {0, 0, 0};
+
+    GLsizei m_element_count[NB_VAO_BUFFERS] = {}; // number of indices of indexed VAOs
+    GLenum m_element_type[NB_VAO_BUFFERS] = {};   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+
+    /***************FRUSTUM CULLING****************/
+
+    Chunk_partition m_chunks[NB_VAO_BUFFERS]; // spatial order of the vertices of each VAO
+    vec4f m_frustum_planes[6];                // model space planes extracted from m_mvp, inside is positive
+    vec3f m_eye {0, 0, 0};                    // camera position in model space
+    float m_pixels_per_unit = 1.f;            // screen size of one model space unit at distance 1
+
+    std::vector<Draw_range> m_draw_ranges;    // visible ranges reused by draw_vao and draw_category
+    std::vector<GLint> m_draw_firsts;
+    std::vector<GLsizei> m_draw_counts;
+    std::vector<const void*> m_draw_offsets;
+    std::vector<GLint> m_draw_base_vertices;
+
+    /***************LEVEL OF DETAIL****************/
+
+    const Lod_mesh* m_lod = nullptr;
+    float m_lod_pixel_error = LOD_PIXEL_ERROR;
+    bool m_is_lod_loaded = false;
+    Faces_callback m_lod_fallback_faces; // until it is called
+
+    /***************DIRECT MESH****************/
+
+    const Direct_mesh* m_direct_mesh = nullptr;
+    bool m_is_direct_mesh_loaded = false;
+
+    /***************SCENE STREAM****************/
+
+    Scene_stream* m_scene_stream = nullptr; // until it is finished
+    Graphics_scene* m_stream_scene = nullptr;
+    vec3f m_stream_cam_position;            // set by fit_camera, the camera was moved if it changed
+
+    /***************POINT CLOUDS****************/
+
+    bool m_point_octree = POINT_OCTREE;
+    std::size_t m_point_budget = POINT_BUDGET;
+    Point_octree m_point_octrees[VAO_COLORED_POINTS + 1]; // for VAO_MONO_POINTS and VAO_COLORED_POINTS
+    std::vector<char> m_octree_selected;
+    std::vector<std::pair<float, std::int32_t>> m_octree_draws; // (point spacing, node)
+
+    /***************MULTI DRAW INDIRECT****************/
+
+    static const int DRAW_PARAMS_LOCATION = 3; // per draw (color source, point spacing), instanced attribute
+
+    bool m_multi_draw_indirect = MULTI_DRAW_INDIRECT;
+    std::size_t m_merged_first[NB_VAO_BUFFERS] = {}; // first vertex of each VAO in the buffer of its category
+    std::size_t m_first_index[NB_VAO_BUFFERS] = {};  // first index of each indexed VAO in the element buffer
+
+    GLuint m_draw_command_buffer = 0;   // GL_DRAW_INDIRECT_BUFFER, written each frame
+    GLuint m_draw_params_buffer = 0;
+    std::size_t m_draw_command_capacity = 0; // in bytes
+    std::size_t m_draw_params_capacity = 0;
+    std::size_t m_draw_command_cursor = 0;   // bytes written since begin_draw_commands
+    std::size_t m_draw_params_cursor = 0;    // draws written since begin_draw_commands
+
+    std::vector<Draw_arrays_command> m_draw_arrays_commands;
+    std::vector<Draw_elements_command> m_draw_elements_commands;
+    std::vector<float> m_draw_params;
+
+    /***************REDRAW SCHEDULING****************/
+
+    std::atomic<bool> m_redraw {true}; // set by every change of the camera, the scene, the settings or the clipping plane
+    bool m_vsync = VSYNC;
+    double m_max_frame_rate = MAX_FRAME_RATE;
+    std::chrono::steady_clock::time_point m_last_frame;
+
+    /***************PROFILING****************/
+
+    Frame_profiler m_profiler {PROFILING_WINDOW, PROFILING};
+    double m_profiling_period = PROFILING_REPORT_PERIOD;
+    std::ofstream m_profiling_csv;
+    std::chrono::steady_clock::time_point m_profiling_start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point m_last_report = m_profiling_start;
+
+    /***************OFFSCREEN****************/
+
+    Offscreen_framebuffer m_offscreen_framebuffer; // target of the screenshots
+
+    /***************CAPTURE****************/
+
+    Frame_writer m_frame_writer {CAPTURE_THREADS, CAPTURE_QUEUE_SIZE, Image_encoder(PNG_COMPRESSION_LEVEL, PNG_THREADS)};
+    Pbo_readback m_readback;                  // screenshots and recorded frames in flight
+    bool m_recording = false;
+    bool m_record_images = false;             // image sequence, otherwise a Y4M stream
+    std::string m_record_prefix;              // image path: prefix, frame number (m_record_digits digits at least)
+    std::string m_record_suffix;              // and suffix
+    int m_record_digits = 0;
+    double m_record_rate = 0;
+    std::size_t m_recorded_frames = 0;
+    std::chrono::steady_clock::time_point m_next_record;
   };
 }
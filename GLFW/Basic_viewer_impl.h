@@ -98,9 +98,6 @@ namespace CGAL::GLFW {
     {
       m_window = create_window(m_window_size.x(), m_window_size.y(), m_title);
       init_buffers();
-
-      glGenBuffers(NB_GL_BUFFERS, m_buffers);
-      glGenVertexArrays(NB_VAO_BUFFERS, m_vao); 
       
       glfwSetWindowUserPointer(m_window, this);
       glfwSetKeyCallback(m_window, key_callback);
@@ -108,169 +105,1634 @@ namespace CGAL::GLFW {
       glfwSetMouseButtonCallback(m_window, mouse_btn_callback);
       glfwSetScrollCallback(m_window, scroll_callback);
       glfwSetFramebufferSizeCallback(m_window, window_size_callback);
+      glfwSetWindowRefreshCallback(m_window, window_refresh_callback);
+      glfwSwapInterval(m_vsync ? 1 : 0);
 
       print_help();
       set_cam_mode(m_cam_mode);
 
-      GLint major, minor;
-      glGetIntegerv(GL_MAJOR_VERSION, &major);
-      glGetIntegerv(GL_MINOR_VERSION, &minor);
-
-      if (major > 4 || major == 4 && minor >= 3){
-        m_is_opengl_4_3 = true;
-      }
-
+      query_gl_features();
       compile_shaders();
+      if (m_is_opengl_4_3) { m_profiler.init_gpu_timers(); }
 
+      m_redraw = true;
       while (!glfwWindowShouldClose(m_window))
       {
-        render_scene();
-        glfwSwapBuffers(m_window);
-        handle_events();
+        update_scene_stream();
+
+        // Nothing is drawn (and the loop sleeps in handle_events) until something changes
+        if (m_redraw.exchange(false) || is_animating() || 
+            !m_is_scene_loaded || !m_are_buffers_initialized || has_dirty_arrays())
+        {
+          wait_next_frame();
+          render_scene();
+          capture_frame();
+          glfwSwapBuffers(m_window);
+          report_profiling();
+        }
+        m_readback.poll(m_frame_writer);
+
+        const bool animating = is_animating();
+        Frame_profiler::Cpu_timer timer(m_profiler, Frame_profiler::HANDLE_EVENTS, animating);
+        handle_events(animating ? 0 : IDLE_WAIT_TIMEOUT);
       }
 
+      finish_captures();
+      if (m_scene_stream != nullptr) { m_scene_stream->on_push({}); }
+      m_profiler.release_gpu_timers();
       glfwTerminate();
+      m_window = nullptr;
     }
 
+    // Renders one frame offscreen, no window is shown (see OFFSCREEN_CONTEXT)
     void Basic_Viewer::make_screenshot(const std::string& pngpath) {
-      m_are_buffers_initialized = false;
-      m_window = create_window(m_window_size.x(), m_window_size.y(), m_title, true);
-      init_buffers();
+      Viewer_view view = current_view();
+      view.path = pngpath;
+      render_views({view});
+    }
 
-      set_cam_mode(m_cam_mode); 
-      
-      GLint major, minor;
-      glGetIntegerv(GL_MAJOR_VERSION, &major);
-      glGetIntegerv(GL_MINOR_VERSION, &minor);
+    void Basic_Viewer::render_views(const std::vector<Viewer_view>& views, std::vector<Captured_frame>* images) {
+      if (images != nullptr) { images->assign(views.size(), Captured_frame()); }
 
-      if (major > 4 || major == 4 && minor >= 3){
-        m_is_opengl_4_3 = true;
+      Offscreen_context context;
+      if (!context.create(m_window_size.x(), m_window_size.y())) {
+        std::cerr << "Could not create the offscreen OpenGL context" << std::endl;
+        context.destroy();
+        return;
       }
+      m_window = context.window();
+      init_buffers();
 
+      query_gl_features();
       compile_shaders();
-      render_scene();
-      glfwSwapBuffers(m_window);
-      screenshot(pngpath);
-      glfwTerminate();
+      if (m_is_opengl_4_3) { m_profiler.init_gpu_timers(); }
+
+      // The scene is uploaded by the first render_scene, the next views only change uniforms and toggles
+      const Viewer_view saved = current_view();
+      for (std::size_t i = 0; i < views.size(); ++i) {
+        apply_view(views[i]);
+        const bool returned = views[i].path.empty() && images != nullptr;
+        if (!views[i].path.empty() || returned) {
+          screenshot(views[i].path, returned ? &(*images)[i] : nullptr);
+        }
+      }
+      finish_captures();
+      apply_view(saved);
+
+      m_offscreen_framebuffer.destroy();
+      m_oit_framebuffer.destroy();
+      m_profiler.release_gpu_timers();
+      m_window = nullptr;
+      context.destroy();
+    }
+
+  Viewer_view Basic_Viewer::current_view() const {
+    Viewer_view view;
+    view.position = m_cam_position;
+    view.forward = m_cam_forward;
+    view.scene_rotation = m_scene_rotation;
+    view.cam_mode = m_cam_mode;
+    view.orth_zoom = m_cam_orth_zoom;
+
+    view.clipping_mode = m_use_clipping_plane;
+    view.clipping_matrix = m_clipping_matrix;
+    view.clipping_plane_rendering = m_clipping_plane_rendering;
+
+    view.draw_vertices = m_draw_vertices;
+    view.draw_edges = m_draw_edges;
+    view.draw_rays = m_draw_rays;
+    view.draw_lines = m_draw_lines;
+    view.draw_faces = m_draw_faces;
+    return view;
+  }
+
+  void Basic_Viewer::apply_view(const Viewer_view& view) {
+    m_cam_position = view.position;
+    m_cam_forward = view.forward;
+    m_scene_rotation = view.scene_rotation;
+    m_cam_orth_zoom = view.orth_zoom;
+    set_cam_mode(view.cam_mode);
+
+    m_use_clipping_plane = view.clipping_mode;
+    m_clipping_matrix = view.clipping_matrix;
+    m_clipping_plane_rendering = view.clipping_plane_rendering;
+
+    m_draw_vertices = view.draw_vertices;
+    m_draw_edges = view.draw_edges;
+    m_draw_rays = view.draw_rays;
+    m_draw_lines = view.draw_lines;
+    m_draw_faces = view.draw_faces;
+  }
+
+  void Basic_Viewer::make_poster(const std::string& path, int width, int height, int supersampling) {
+    supersampling = std::max(supersampling, 1);
+
+    Offscreen_context context;
+    if (!context.create(m_window_size.x(), m_window_size.y())) {
+      std::cerr << "Could not create the offscreen OpenGL context" << std::endl;
+      context.destroy();
+      return;
     }
+    m_window = context.window();
+    init_buffers();
+
+    query_gl_features();
+    compile_shaders();
+    if (m_is_opengl_4_3) { m_profiler.init_gpu_timers(); }
+
+    Image_stream stream(m_frame_writer.encoder());
+    if (!stream.open(path, width, height)) {
+      std::cerr << "Could not open " << path << std::endl;
+    } else {
+      GLint maxRenderbuffer = 0, maxViewport[2] = {0, 0};
+      glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbuffer);
+      glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+      const int maxSamples = std::min({POSTER_TILE_SIZE, static_cast<int>(maxRenderbuffer), 
+                                       static_cast<int>(maxViewport[0]), static_cast<int>(maxViewport[1])});
+      const int margin = POSTER_TILE_MARGIN;
+      const int tileSize = std::max(1, (maxSamples - 2 * margin) / supersampling); // in pixels of the image
+
+      // The samples are the pixels of a virtual image, sizes in pixels are scaled like it
+      const vec2i savedWindowSize = m_window_size;
+      const float savedSizes[] = {m_size_points, m_size_edges, m_size_rays, m_size_lines, m_lod_pixel_error};
+      m_size_points *= supersampling;
+      m_size_edges *= supersampling;
+      m_size_rays *= supersampling;
+      m_size_lines *= supersampling;
+      m_lod_pixel_error *= supersampling;
+
+      const vec2i imageSize(width * supersampling, height * supersampling);
+      m_window_size = imageSize;
+      set_cam_mode(m_cam_mode);
+      const mat4f projection = m_cam_projection;
+
+      m_readback.init(CAPTURE_PBO_COUNT);
+      const std::size_t ring = m_readback.size();
+      std::vector<Captured_frame> tiles(ring + 1);  // a tile is downsampled when the ring returns it
+      std::vector<unsigned char> bands[2];          // one filled while the other is encoded
+      std::thread encoding;
+
+      const int nbTilesX = (width + tileSize - 1) / tileSize;
+      for (int top = 0, band = 0; top < height; top += tileSize, band = 1 - band) {
+        const int rows = std::min(tileSize, height - top);
+        std::vector<unsigned char>& pixels = bands[band];
+        pixels.resize(static_cast<std::size_t>(width) * rows * 3);
+
+        // Box filter of the samples of a tile, without its margin
+        auto downsample = [&](int tx) {
+          const Captured_frame& tile = tiles[tx % tiles.size()];
+          const int left = tx * tileSize, cols = std::min(tileSize, width - left);
+          const float weight = 1.f / (supersampling * supersampling);
+          for (int y = 0; y < rows; ++y) {
+            unsigned char* out = &pixels[(static_cast<std::size_t>(y) * width + left) * 3];
+            for (int x = 0; x < cols; ++x, out += 3) {
+              float sum[3] = {0, 0, 0};
+              for (int j = 0; j < supersampling; ++j) {
+                const unsigned char* in = &tile.pixels[(static_cast<std::size_t>(margin + y * supersampling + j) * tile.width + margin + x * supersampling) * 3];
+                for (int i = 0; i < 3 * supersampling; ++i) { sum[i % 3] += in[i]; }
+              }
+              for (int c = 0; c < 3; ++c) { out[c] = static_cast<unsigned char>(sum[c] * weight + 0.5f); }
+            }
+          }
+        };
+
+        for (int tx = 0; tx < nbTilesX; ++tx) {
+          const int left = tx * tileSize, cols = std::min(tileSize, width - left);
+          const vec2i tileMin(left * supersampling - margin, top * supersampling - margin);
+          const vec2i tileMax((left + cols) * supersampling + margin, (top + rows) * supersampling + margin);
+
+          m_window_size = tileMax - tileMin;
+          m_cam_projection = tile_projection(projection, imageSize, tileMin, tileMax);
+          screenshot("", &tiles[tx % tiles.size()]);
+
+          if (tx >= static_cast<int>(ring)) { downsample(tx - static_cast<int>(ring)); }
+        }
+        m_readback.flush(m_frame_writer);
+        for (int tx = std::max(0, nbTilesX - static_cast<int>(ring)); tx < nbTilesX; ++tx) { downsample(tx); }
+
+        if (encoding.joinable()) { encoding.join(); }
+        encoding = std::thread([&stream, &pixels, rows] { stream.write_rows(pixels.data(), rows); });
+      }
+      if (encoding.joinable()) { encoding.join(); }
+      if (!stream.close()) { std::cerr << "Could not write " << path << std::endl; }
+
+      m_window_size = savedWindowSize;
+      set_cam_mode(m_cam_mode);
+      m_size_points = savedSizes[0];
+      m_size_edges = savedSizes[1];
+      m_size_rays = savedSizes[2];
+      m_size_lines = savedSizes[3];
+      m_lod_pixel_error = savedSizes[4];
+    }
+
+    finish_captures();
+    m_offscreen_framebuffer.destroy();
+    m_oit_framebuffer.destroy();
+    m_profiler.release_gpu_timers();
+    m_window = nullptr;
+    context.destroy();
+  }
+
+  // Part [min, max) (in pixels from the top left corner) of the image of the given projection:
+  // the clip space is scaled and translated so that the part covers the whole viewport,
+  // for perspective and orthographic projections alike
+  Basic_Viewer::mat4f Basic_Viewer::tile_projection(const mat4f& projection, const vec2i& imageSize,
+                                                    const vec2i& min, const vec2i& max) const {
+    const float x0 = 2.f * min.x() / imageSize.x() - 1.f, x1 = 2.f * max.x() / imageSize.x() - 1.f;
+    const float y0 = 1.f - 2.f * max.y() / imageSize.y(), y1 = 1.f - 2.f * min.y() / imageSize.y();
+
+    mat4f crop = mat4f::Identity();
+    crop(0, 0) = 2.f / (x1 - x0);
+    crop(0, 3) = -(x0 + x1) / (x1 - x0);
+    crop(1, 1) = 2.f / (y1 - y0);
+    crop(1, 3) = -(y0 + y1) / (y1 - y0);
+    return crop * projection;
+  }
+
+  void Basic_Viewer::redraw() {
+    m_redraw = true;
+    // Wakes the event loop up
+    if (m_window != nullptr) { glfwPostEmptyEvent(); }
+  }
+
+  void Basic_Viewer::vsync(bool b) {
+    m_vsync = b;
+    if (m_window != nullptr) { glfwSwapInterval(b ? 1 : 0); }
+  }
+
+  void Basic_Viewer::scene_stream(Scene_stream* stream, Graphics_scene* scene) {
+    m_scene_stream = stream;
+    m_stream_scene = scene;
+    m_scene = scene;
+    m_is_scene_loaded = false;
+    m_are_buffers_initialized = false;
+    m_stream_cam_position = m_cam_position;
+    if (stream != nullptr) { stream->on_push([this] { redraw(); }); }
+  }
+
+  // Applies the pending updates of the stream. Once it is finished, everything is loaded again
+  // with the layout of a static scene.
+  void Basic_Viewer::update_scene_stream() {
+    if (m_scene_stream == nullptr) return;
+
+    Scene_stream::Replacement replacement;
+    if (m_scene_stream->update(*m_stream_scene, replacement)) {
+      if (replacement.scene != nullptr) {
+        // The streamed arrays are released, the meshes of the new scene are drawn with it
+        m_stream_scene->clear();
+        m_stream_scene = replacement.scene.get();
+        set_scene(m_stream_scene);
+        if (replacement.lod != nullptr) { lod_mesh(replacement.lod); }
+        if (replacement.direct != nullptr) { direct_mesh(replacement.direct); }
+        if (replacement.lod_fallback_faces) { lod_fallback_faces(std::move(replacement.lod_fallback_faces)); }
+      }
+      if (m_cam_position == m_stream_cam_position) { fit_camera(); }
+      m_redraw = true;
+    }
+
+    if (m_scene_stream->finished()) {
+      m_scene_stream->on_push({});
+      m_scene_stream = nullptr;
+      m_is_scene_loaded = false;
+      m_are_buffers_initialized = false;
+      m_redraw = true;
+    }
+  }
+
+  // Camera at the same direction, the bounding sphere of the scene in the field of view (in perspective)
+  void Basic_Viewer::fit_camera() {
+    const auto& bb = m_scene->bounding_box();
+    if (!(bb.xmin() <= bb.xmax())) return;
+
+    const vec3f min(bb.xmin(), bb.ymin(), bb.zmin()), max(bb.xmax(), bb.ymax(), bb.zmax());
+    const vec3f center = (m_scene_rotation * vec4f(0.5f * (min.x() + max.x()), 0.5f * (min.y() + max.y()),
+                                                   0.5f * (min.z() + max.z()), 1.f)).head<3>();
+    const float radius = std::max(0.5f * (max - min).norm(), 1e-6f);
+
+    const float halfFov = radians(45.f) / 2;
+    const float ratio = static_cast<float>(m_window_size.x()) / std::max(m_window_size.y(), 1);
+    const float halfFovX = std::atan(std::tan(halfFov) * ratio);
+    m_cam_position = center - m_cam_forward.normalized() * (radius / std::sin(std::min(halfFov, halfFovX)));
+    m_stream_cam_position = m_cam_position;
+  }
+
+  // Frame rate cap: sleeps until 1/m_max_frame_rate seconds after the previous frame
+  void Basic_Viewer::wait_next_frame() {
+    if (m_max_frame_rate > 0) {
+      const auto period = std::chrono::duration<double>(1.0 / m_max_frame_rate);
+      const auto next = m_last_frame + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+      if (next > std::chrono::steady_clock::now()) { std::this_thread::sleep_until(next); }
+    }
+    m_last_frame = std::chrono::steady_clock::now();
+  }
+
+  void Basic_Viewer::profiling_report(double period, const std::string& csvPath) {
+    m_profiling_period = period;
+    m_profiling_start = m_last_report = std::chrono::steady_clock::now();
+
+    m_profiling_csv.close();
+    if (!csvPath.empty()) {
+      m_profiling_csv.open(csvPath);
+      Frame_profiler::write_csv_header(m_profiling_csv);
+    }
+  }
+
+  void Basic_Viewer::report_profiling() {
+    if (!m_profiler.enabled() || m_profiling_period <= 0) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_last_report < std::chrono::duration<double>(m_profiling_period)) return;
+    m_last_report = now;
+
+    if (m_profiling_csv.is_open()) {
+      m_profiler.write_csv(m_profiling_csv, std::chrono::duration<double>(now - m_profiling_start).count());
+    } else {
+      m_profiler.print(std::cout);
+    }
+  }
+
+  // Splits the path of an image sequence around its frame number: one %d or %0Nd (N digits at least),
+  // %% for a percent sign. Returns false for any other conversion or without frame number.
+  inline bool split_frame_pattern(const std::string& pattern, std::string& prefix, std::string& suffix, int& digits) {
+    prefix.clear();
+    suffix.clear();
+    bool found = false;
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+      std::string& part = found ? suffix : prefix;
+      if (pattern[i] != '%') {
+        part += pattern[i];
+        continue;
+      }
+
+      if (i + 1 < pattern.size() && pattern[i + 1] == '%') {
+        part += '%';
+        ++i;
+        continue;
+      }
+
+      // %d or %0Nd
+      std::size_t end = i + 1;
+      digits = 0;
+      if (end < pattern.size() && pattern[end] == '0') {
+        while (++end < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[end]))) {
+          digits = std::min(10 * digits + (pattern[end] - '0'), 64);
+        }
+      }
+      if (found || end >= pattern.size() || pattern[end] != 'd') return false;
+      found = true;
+      i = end;
+    }
+    return found;
+  }
+
+  void Basic_Viewer::start_recording(const std::string& path, double fps) {
+    stop_recording();
+
+    const bool stream = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    if (!stream) {
+      // One file per frame, the frame number is added before the extension when the path has no pattern
+      std::string pattern = path;
+      if (path.find('%') == std::string::npos) {
+        const std::size_t dot = path.find_last_of('.');
+        pattern.insert(dot == std::string::npos ? path.size() : dot, "_%05d");
+      }
+      if (!split_frame_pattern(pattern, m_record_prefix, m_record_suffix, m_record_digits)) {
+        std::cerr << "Invalid recording path " << path << ": one %d or %0Nd is expected, %% for a percent sign" << std::endl;
+        return;
+      }
+    } else if (!m_frame_writer.open_stream(path, fps > 0 ? fps : 60)) {
+      std::cerr << "Could not open " << path << std::endl;
+      return;
+    }
+
+    m_record_images = !stream;
+    m_record_rate = fps;
+    m_recorded_frames = 0;
+    m_next_record = std::chrono::steady_clock::now();
+    m_recording = true;
+    redraw();
+  }
+
+  void Basic_Viewer::stop_recording() {
+    if (!m_recording) return;
+
+    m_recording = false;
+    if (m_readback.is_initialized()) { m_readback.flush(m_frame_writer); }
+    m_frame_writer.close_stream();
+    std::cout << m_recorded_frames << " frames recorded" << std::endl;
+  }
+
+  // Queues the readback of the frame in the back buffer when it is recorded
+  void Basic_Viewer::capture_frame() {
+    if (!m_recording) return;
+
+    if (m_record_rate > 0) {
+      const auto now = std::chrono::steady_clock::now();
+      if (now < m_next_record) return;
+
+      const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1. / m_record_rate));
+      m_next_record += period;
+      // Frames that could not be drawn in time are not caught up
+      if (m_next_record < now) { m_next_record = now + period; }
+    }
+
+    std::string path;
+    if (m_record_images) {
+      const std::string number = std::to_string(m_recorded_frames);
+      path = m_record_prefix;
+      if (number.size() < static_cast<std::size_t>(m_record_digits)) { path.append(m_record_digits - number.size(), '0'); }
+      path += number;
+      path += m_record_suffix;
+    }
+
+    m_readback.init(CAPTURE_PBO_COUNT);
+    glReadBuffer(GL_BACK);
+    m_readback.read(m_window_size.x(), m_window_size.y(), path, m_frame_writer);
+    ++m_recorded_frames;
+  }
+
+  // Writes the pending screenshots and recorded frames, the context must still be current
+  void Basic_Viewer::finish_captures() {
+    stop_recording();
+    if (m_readback.is_initialized()) {
+      m_readback.flush(m_frame_writer);
+      m_readback.destroy();
+    }
+    m_frame_writer.wait();
+  }
+
+  void Basic_Viewer::query_gl_features() {
+    GLint major, minor;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+    if (major > 4 || (major == 4 && minor >= 3)){
+      m_is_opengl_4_3 = true;
+
+      GLint maxClipDistances = 8;
+      glGetIntegerv(GL_MAX_CLIP_DISTANCES, &maxClipDistances);
+      m_max_clip_distances = maxClipDistances;
+    }
+
+    // glad only loads core 4.4 entry points, ARB_buffer_storage exposes the same function on older contexts
+    bool buffer_storage = major > 4 || (major == 4 && minor >= 4);
+    if (!buffer_storage && glfwExtensionSupported("GL_ARB_buffer_storage")) {
+      glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+      buffer_storage = true;
+    }
+    m_has_buffer_storage = buffer_storage && glBufferStorage != nullptr;
+  }
 
   void Basic_Viewer::compile_shaders() { 
-    const char* face_vert = m_is_opengl_4_3 ? vertex_source_color : vertex_source_color_comp;
-    const char* face_frag = m_is_opengl_4_3 ? fragment_source_color : fragment_source_color_comp;
-    const char* pl_vert = m_is_opengl_4_3 ? vertex_source_p_l : vertex_source_p_l_comp;
-    const char* pl_frag = m_is_opengl_4_3 ? fragment_source_p_l : fragment_source_p_l_comp;
-    const char* plane_vert = vertex_source_clipping_plane;
-    const char* plane_frag = fragment_source_clipping_plane;
+    std::string header = "#version 430 core\n";
+    header += "#define MAX_CLIP_DISTANCES " + std::to_string(m_max_clip_distances) + "\n";
+    if (use_compact_vertices()) { header += "#define COMPACT_VERTICES\n"; }
+    m_compiled_compact_vertices = use_compact_vertices();
+
+    const std::string block = header + uniform_block_frame;
+    const std::string face_vert = m_is_opengl_4_3 ? block + vertex_source_face : vertex_source_color_comp;
+    const std::string face_frag = m_is_opengl_4_3 ? block + fragment_source_face : fragment_source_color_comp;
+    const std::string pl_vert = m_is_opengl_4_3 ? block + vertex_source_pl : vertex_source_p_l_comp;
+    const std::string pl_frag = m_is_opengl_4_3 ? block + fragment_source_pl : fragment_source_p_l_comp;
+    const std::string plane_vert = m_is_opengl_4_3 ? block + vertex_source_plane : vertex_source_clipping_plane;
+    const std::string plane_frag = m_is_opengl_4_3 ? block + fragment_source_plane : fragment_source_clipping_plane;
+
+    m_face_shader.destroy();
+    m_pl_shader.destroy();
+    m_plane_shader.destroy();
+    m_oit_composite_shader.destroy();
+    m_copy_shader.destroy();
+
+    // All the programs at once: from the binary cache, or compiled in parallel when the driver can
+    std::string cacheDirectory;
+    if (m_shader_cache) {
+      cacheDirectory = m_shader_cache_directory.empty() ? Program_builder::default_directory() : m_shader_cache_directory;
+    }
+    Program_builder builder(cacheDirectory);
+    builder.add(m_face_shader, face_vert, face_frag, "FACE");
+    builder.add(m_pl_shader, pl_vert, pl_frag, "PL");
+    builder.add(m_plane_shader, plane_vert, plane_frag, "PLANE");
+    if (m_is_opengl_4_3) {
+      builder.add(m_oit_composite_shader, header + vertex_source_fullscreen, header + fragment_source_oit_composite, "OIT COMPOSITE");
+      builder.add(m_copy_shader, header + vertex_source_fullscreen, header + fragment_source_copy, "COPY");
+    }
+    builder.build();
+
+    m_face_uniforms.rendering_mode = m_face_shader.getUniform("rendering_mode");
+    m_face_uniforms.mono_color = m_face_shader.getUniform("mono_color");
+    m_pl_uniforms.rendering_mode = m_pl_shader.getUniform("rendering_mode");
+    m_pl_uniforms.mono_color = m_pl_shader.getUniform("mono_color");
+  }
+
+  void Basic_Viewer::update_scene_array(int gsEnum){
+    mark_array_dirty(gsEnum);
+    redraw();
+  }
+
+  void Basic_Viewer::update_scene_array(int gsEnum, std::size_t first, std::size_t count){
+    mark_array_dirty(gsEnum, first, count);
+    redraw();
+  }
+
+  void Basic_Viewer::mark_array_dirty(int gsEnum){
+    mark_array_dirty(gsEnum, 0, std::numeric_limits<std::size_t>::max() / (3 * sizeof(float)));
+  }
+
+  void Basic_Viewer::mark_array_dirty(int gsEnum, std::size_t first, std::size_t count){
+    const std::size_t elementSize = 3 * sizeof(float);
+    Array_state& state = m_array_states[gsEnum];
+
+    const std::size_t begin = first * elementSize;
+    const std::size_t end = begin + count * elementSize;
+
+    if (state.dirty_begin < state.dirty_end) {
+      state.dirty_begin = std::min(state.dirty_begin, begin);
+      state.dirty_end = std::max(state.dirty_end, end);
+    } else {
+      state.dirty_begin = begin;
+      state.dirty_end = end;
+    }
+    state.version++;
+  }
+
+  bool Basic_Viewer::is_array_dirty(int gsEnum) const {
+    const Array_state& state = m_array_states[gsEnum];
+    return state.version != state.uploaded_version ||
+           m_scene->get_size_of_index(gsEnum) != state.uploaded_size;
+  }
+
+  bool Basic_Viewer::has_dirty_arrays() const {
+    for (int i = 0; i < Graphics_scene::LAST_INDEX; ++i) {
+      if (is_array_dirty(i)) return true;
+    }
+    return false;
+  }
+
+  bool Basic_Viewer::is_any_dirty(std::initializer_list<Vertex_attribute> attributes) const {
+    for (const Vertex_attribute& attribute : attributes) {
+      if (is_array_dirty(attribute.gsEnum)) return true;
+    }
+    return false;
+  }
+
+  // Dirty byte range [first, second) of an array: the modified and the appended bytes, the whole array if it shrank
+  std::pair<std::size_t, std::size_t> Basic_Viewer::dirty_bytes(int gsEnum) const {
+    const Array_state& state = m_array_states[gsEnum];
+    const std::size_t size = m_scene->get_size_of_index(gsEnum);
+
+    if (size < state.uploaded_size) return {0, size};
+    std::pair<std::size_t, std::size_t> range(size, 0);
+    if (size > state.uploaded_size) { range = {state.uploaded_size, size}; }
+    if (state.version != state.uploaded_version) {
+      range.first = std::min(range.first, std::min(state.dirty_begin, size));
+      range.second = std::max(range.second, std::min(state.dirty_end, size));
+    }
+    if (range.first >= range.second) return {0, 0};
+    return range;
+  }
+
+  void Basic_Viewer::clear_dirty_arrays(){
+    for (int i = 0; i < Graphics_scene::LAST_INDEX; ++i) {
+      Array_state& state = m_array_states[i];
+      state.uploaded_version = state.version;
+      state.uploaded_size = m_scene->get_size_of_index(i);
+      state.dirty_begin = state.dirty_end = 0;
+    }
+  }
+
+  void Basic_Viewer::update_normal_arrays(){
+    for (int i = Graphics_scene::BEGIN_NORMAL; i < Graphics_scene::END_NORMAL; ++i) {
+      mark_array_dirty(i);
+    }
+  }
+
+  // Writes size bytes at offset in buffer i. The buffer storage is only reallocated (orphaned) 
+  // when it has to grow beyond total bytes, in that case data must hold the whole buffer.
+  void Basic_Viewer::upload_buffer(int i, GLenum target, std::size_t total, std::size_t offset, std::size_t size, const void* data){
+    glBindBuffer(target, m_buffers[i]);
+
+    if (total > m_buffer_capacity[i]) {
+      // Streamed arrays grow again and again, they get room for the next chunks
+      const std::size_t capacity = is_streaming() && m_buffer_capacity[i] > 0 ? 
+                                   std::max(total, 2 * m_buffer_capacity[i]) : total;
+      glBufferData(target, capacity, capacity == total ? data : nullptr, GL_STATIC_DRAW);
+      if (capacity != total) { glBufferSubData(target, 0, total, data); }
+      m_buffer_capacity[i] = capacity;
+      return;
+    }
+
+    if (size > 0) {
+      glBufferSubData(target, offset, size, data);
+    }
+  }
+
+  void Basic_Viewer::load_buffer(int i, int location, const std::vector<float>& vector, int dataCount){
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
+
+    glBufferData(GL_ARRAY_BUFFER, vector.size() * sizeof(float), vector.data(), GL_STATIC_DRAW);
+    m_buffer_capacity[i] = vector.size() * sizeof(float);
+
+    glVertexAttribPointer(location, dataCount, GL_FLOAT, GL_FALSE, dataCount * sizeof(float), nullptr);
+
+    glEnableVertexAttribArray(location);
+  }
+
+
+  void Basic_Viewer::load_buffer(int i, int location, int gsEnum, int dataCount){ 
+    const std::vector<float>& vector = m_scene->get_array_of_index(gsEnum);
+    const std::size_t total = vector.size() * sizeof(float);
+
+    std::pair<std::size_t, std::size_t> range = dirty_bytes(gsEnum);
+    if (total > m_buffer_capacity[i]) { range = {0, total}; }
+
+    upload_buffer(i, GL_ARRAY_BUFFER, total, range.first, range.second - range.first, 
+                  reinterpret_cast<const char*>(vector.data()) + range.first);
+
+    glVertexAttribPointer(location, dataCount, GL_FLOAT, GL_FALSE, dataCount * sizeof(float), nullptr);
+    glEnableVertexAttribArray(location);
+  }
+
+  // Size in bytes of one attribute in the vertex buffers, depending on the vertex format
+  std::size_t Basic_Viewer::attribute_size(int gsEnum) const {
+    if (!use_compact_vertices()) return 3 * sizeof(float);
+    if (gsEnum < Graphics_scene::END_POS) return 4 * sizeof(std::uint16_t);  // xyz + padding
+    if (gsEnum < Graphics_scene::END_COLOR) return 4 * sizeof(std::uint8_t); // rgba
+    return 2 * sizeof(std::int16_t);                                          // octahedron
+  }
+
+  std::size_t Basic_Viewer::vertex_size(std::initializer_list<Vertex_attribute> attributes) const {
+    std::size_t size = 0;
+    for (const Vertex_attribute& attribute : attributes) {
+      size += attribute_size(attribute.gsEnum);
+    }
+    return size;
+  }
+
+  // https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+  inline void encode_octahedron(const float* n, std::int16_t* dst) {
+    const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    float x = l1 > 0 ? n[0] / l1 : 0.f;
+    float y = l1 > 0 ? n[1] / l1 : 0.f;
+
+    if (n[2] < 0) {
+      const float ox = (1.f - std::abs(y)) * (x >= 0 ? 1.f : -1.f);
+      const float oy = (1.f - std::abs(x)) * (y >= 0 ? 1.f : -1.f);
+      x = ox;
+      y = oy;
+    }
+
+    dst[0] = static_cast<std::int16_t>(std::round(std::clamp(x, -1.f, 1.f) * 32767.f));
+    dst[1] = static_cast<std::int16_t>(std::round(std::clamp(y, -1.f, 1.f) * 32767.f));
+  }
+
+  void Basic_Viewer::pack_attribute(int gsEnum, const float* src, char* dst) const {
+    if (!use_compact_vertices()) {
+      std::memcpy(dst, src, 3 * sizeof(float));
+      return;
+    }
+
+    if (gsEnum < Graphics_scene::END_POS) {
+      // 16-bit unorm relative to the scene bounding box, dequantized in the vertex shader
+      std::uint16_t q[4] = {0, 0, 0, 0};
+      for (int c = 0; c < 3; ++c) {
+        const float t = (src[c] - m_quantization_min[c]) / m_quantization_extent[c];
+        q[c] = static_cast<std::uint16_t>(std::round(std::clamp(t, 0.f, 1.f) * 65535.f));
+      }
+      std::memcpy(dst, q, sizeof(q));
+    } else if (gsEnum < Graphics_scene::END_COLOR) {
+      std::uint8_t c[4] = {0, 0, 0, 255};
+      for (int k = 0; k < 3; ++k) {
+        c[k] = static_cast<std::uint8_t>(std::round(std::clamp(src[k], 0.f, 1.f) * 255.f));
+      }
+      std::memcpy(dst, c, sizeof(c));
+    } else {
+      std::int16_t o[2];
+      encode_octahedron(src, o);
+      std::memcpy(dst, o, sizeof(o));
+    }
+  }
+
+  // Quantization box of the compact positions. Returns true if it changed, every position must be packed again.
+  bool Basic_Viewer::update_quantization_box() {
+    const auto& bb = m_scene->bounding_box();
+    const vec3f bbMin(bb.xmin(), bb.ymin(), bb.zmin());
+    vec3f extent(bb.xmax() - bb.xmin(), bb.ymax() - bb.ymin(), bb.zmax() - bb.zmin());
+    for (int c = 0; c < 3; ++c) {
+      if (!(extent[c] > 0)) extent[c] = 1.f;
+    }
+
+    if (bbMin == m_quantization_min && extent == m_quantization_extent) return false;
+
+    m_quantization_min = bbMin;
+    m_quantization_extent = extent;
+    return true;
+  }
+
+  // order maps the vertices of the packed array to the vertices of the scene array (identity if empty)
+  std::size_t Basic_Viewer::interleave(std::initializer_list<Vertex_attribute> attributes, std::vector<char>& array,
+                                       const std::vector<std::uint32_t>& order,
+                                       std::size_t first, std::size_t last) const {
+    const std::size_t stride = vertex_size(attributes);
+    last = std::min(last, m_scene->number_of_elements(attributes.begin()->gsEnum));
+    first = std::min(first, last);
+
+    std::vector<const float*> sources;
+    for (const Vertex_attribute& attribute : attributes) {
+      sources.push_back(m_scene->get_array_of_index(attribute.gsEnum).data());
+    }
+
+    array.clear();
+    pack_vertices(attributes, sources.data(), order, first, last, array);
+    return stride;
+  }
+
+  // sources: one array of 3 floats per vertex for each attribute, packed as the scene array attribute.gsEnum
+  // (a nullptr source leaves the attribute to zero). The vertices are appended to array.
+  void Basic_Viewer::pack_vertices(std::initializer_list<Vertex_attribute> attributes, const float* const* sources,
+                                   const std::vector<std::uint32_t>& order, std::size_t first, std::size_t last,
+                                   std::vector<char>& array) const {
+    // Write every vertex in a single pass: [attr0 | attr1 | ...] per vertex
+    const std::size_t offset = array.size();
+    array.resize(offset + (last - first) * vertex_size(attributes));
+    char* dst = array.data() + offset;
+    for (std::size_t v = first; v < last; ++v) {
+      const std::size_t sv = order.empty() ? v : order[v];
+      int a = 0;
+      for (const Vertex_attribute& attribute : attributes) {
+        const float* source = sources[a++];
+        if (source != nullptr) {
+          pack_attribute(attribute.gsEnum, source + sv * 3, dst);
+        } else {
+          std::memset(dst, 0, attribute_size(attribute.gsEnum));
+        }
+        dst += attribute_size(attribute.gsEnum);
+      }
+    }
+  }
+
+  void Basic_Viewer::set_interleaved_attributes(std::initializer_list<Vertex_attribute> attributes){
+    const GLsizei stride = static_cast<GLsizei>(vertex_size(attributes));
+
+    std::size_t offset = 0;
+    for (const Vertex_attribute& attribute : attributes) {
+      const void* pointer = reinterpret_cast<void*>(offset);
+      const int gsEnum = attribute.gsEnum;
+
+      if (!use_compact_vertices()) {
+        glVertexAttribPointer(attribute.location, 3, GL_FLOAT, GL_FALSE, stride, pointer);
+      } else if (gsEnum < Graphics_scene::END_POS) {
+        glVertexAttribPointer(attribute.location, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, pointer);
+      } else if (gsEnum < Graphics_scene::END_COLOR) {
+        glVertexAttribPointer(attribute.location, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, pointer);
+      } else {
+        glVertexAttribPointer(attribute.location, 2, GL_SHORT, GL_TRUE, stride, pointer);
+      }
+
+      glEnableVertexAttribArray(attribute.location);
+      offset += attribute_size(gsEnum);
+    }
+  }
+
+  // Union of the dirty ranges of all attributes, in vertices
+  std::pair<std::size_t, std::size_t> Basic_Viewer::dirty_vertices(std::initializer_list<Vertex_attribute> attributes) const {
+    const std::size_t elementSize = 3 * sizeof(float);
+    const std::size_t nbVertices = m_scene->number_of_elements(attributes.begin()->gsEnum);
+
+    std::size_t first = nbVertices, last = 0;
+    for (const Vertex_attribute& attribute : attributes) {
+      std::pair<std::size_t, std::size_t> range = dirty_bytes(attribute.gsEnum);
+      if (range.first >= range.second) continue;
+      first = std::min(first, range.first / elementSize);
+      last = std::max(last, std::min(nbVertices, (range.second + elementSize - 1) / elementSize));
+    }
+    if (first >= last) return {0, 0};
+    return {first, last};
+  }
+
+  // The vertices [first, last) of the scene array of a VAO are scattered by its chunks in the vertex buffer:
+  // range of their new indices
+  std::pair<std::size_t, std::size_t> Basic_Viewer::packed_range(int vao, std::pair<std::size_t, std::size_t> vertices) const {
+    const std::vector<std::uint32_t>& inverse = inverse_vertex_order(vao);
+    if (inverse.empty() || vertices.first >= vertices.second) return vertices;
+
+    std::size_t first = inverse.size(), last = 0;
+    for (std::size_t v = vertices.first; v < std::min(vertices.second, inverse.size()); ++v) {
+      first = std::min<std::size_t>(first, inverse[v]);
+      last = std::max<std::size_t>(last, inverse[v] + 1);
+    }
+    if (first >= last) return {0, 0};
+    return {first, last};
+  }
+
+  void Basic_Viewer::load_interleaved_buffer(int i, int vao, std::initializer_list<Vertex_attribute> attributes,
+                                             bool reordered){
+    const std::size_t vertexSize = vertex_size(attributes);
+    const std::size_t nbVertices = m_scene->number_of_elements(attributes.begin()->gsEnum);
+
+    // Chunked vertices keep their place while the chunks are not built again: the dirty vertices are written
+    // in place, within the range of their new indices
+    std::pair<std::size_t, std::size_t> range = packed_range(vao, dirty_vertices(attributes));
+    if (nbVertices * vertexSize > m_buffer_capacity[i] || reordered) {
+      range = {0, nbVertices};
+    }
+
+    // Only the dirty vertices are packed again
+    auto& array = m_interleaved_array;
+    interleave(attributes, array, vertex_order(vao), range.first, range.second);
+
+    upload_buffer(i, GL_ARRAY_BUFFER, nbVertices * vertexSize, 
+                  range.first * vertexSize, array.size(), array.data());
+
+    set_interleaved_attributes(attributes);
+  }
+
+  // Spatial chunks (or point octree) of a VAO. Chunks are built again when their positions are resized or all
+  // modified, otherwise only the boxes of the chunks with modified positions are refit and the vertices keep their
+  // order. The octree subsamples depend on every position, it is built again when any changes.
+  // Returns true if the order of the vertices changed, the vertex buffer must then be packed again.
+  bool Basic_Viewer::update_chunks(int vao, int gsEnum){
+    const std::vector<float>& positions = m_scene->get_array_of_index(gsEnum);
+    bool reordered = false;
+    if (vao <= VAO_COLORED_POINTS) {
+      if (use_point_octree(gsEnum)) {
+        reordered = !m_chunks[vao].empty();
+        m_chunks[vao].clear();
+        if (is_array_dirty(gsEnum)) { 
+          m_point_octrees[vao].build(positions); 
+          reordered = true;
+        }
+        return reordered;
+      }
+      reordered = !m_point_octrees[vao].empty();
+      m_point_octrees[vao].clear();
+    }
+
+    if (!use_chunks()) {
+      reordered = reordered || !m_chunks[vao].empty();
+      m_chunks[vao].clear();
+      return reordered;
+    }
+
+    if (!is_array_dirty(gsEnum)) return reordered;
+
+    const std::size_t size = positions.size() * sizeof(float);
+    const std::pair<std::size_t, std::size_t> range = dirty_bytes(gsEnum);
+    const bool resized = size != m_array_states[gsEnum].uploaded_size;
+    if (!reordered && !m_chunks[vao].empty() && !resized && (range.first > 0 || range.second < size)) {
+      const std::size_t elementSize = 3 * sizeof(float);
+      const std::pair<std::size_t, std::size_t> vertices = 
+        packed_range(vao, {range.first / elementSize, (range.second + elementSize - 1) / elementSize});
+      m_chunks[vao].refit(positions, vertices.first, vertices.second);
+      return false;
+    }
+
+    const int primitiveSize = vao >= VAO_MONO_FACES ? 3 : (vao >= VAO_MONO_SEGMENTS ? 2 : 1);
+    m_chunks[vao].build(positions, primitiveSize, CHUNK_SIZE);
+    return true;
+  }
+
+  const std::vector<std::uint32_t>& Basic_Viewer::vertex_order(int vao) const {
+    if (vao <= VAO_COLORED_POINTS && !m_point_octrees[vao].empty()) {
+      return m_point_octrees[vao].point_order();
+    }
+    return m_chunks[vao].vertex_order();
+  }
+
+  const std::vector<std::uint32_t>& Basic_Viewer::inverse_vertex_order(int vao) const {
+    if (vao <= VAO_COLORED_POINTS && !m_point_octrees[vao].empty()) {
+      return m_point_octrees[vao].inverse_point_order();
+    }
+    return m_chunks[vao].inverse_vertex_order();
+  }
+
+  void Basic_Viewer::load_vertices(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> attributes){
+    if (!is_any_dirty(attributes)) {
+      bufn += use_interleaved_layout() ? 1 : static_cast<unsigned int>(attributes.size());
+      return;
+    }
+
+    const bool reordered = update_chunks(vao, attributes.begin()->gsEnum);
+
+    if (use_interleaved_layout()) {
+      load_interleaved_buffer(bufn++, vao, attributes, reordered);
+      return;
+    }
+
+    for (const Vertex_attribute& attribute : attributes) {
+      // Dynamic positions are read from their ring (see update_dynamic_geometry)
+      if (m_dynamic_geometry && attribute.gsEnum < Graphics_scene::END_POS) {
+        ++bufn;
+        continue;
+      }
+      load_buffer(bufn++, attribute.location, attribute.gsEnum, 3);
+    }
+  }
+
+  // Bitwise FNV-1a hash of one packed vertex (its size is a multiple of 4 bytes)
+  inline std::uint64_t hash_vertex(const char* vertex, std::size_t size) {
+    std::uint64_t h = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; i += sizeof(std::uint32_t)) {
+      std::uint32_t bits;
+      std::memcpy(&bits, vertex + i, sizeof(bits));
+      h ^= bits;
+      h *= 1099511628211ull;
+    }
+    return h ^ (h >> 32);
+  }
+
+  // Welds the nbVertices packed vertices starting at byte offset of array: they are compacted in place
+  // and indices maps each of them to its welded vertex. Returns the number of welded vertices.
+  std::size_t Basic_Viewer::weld_vertices(std::vector<char>& array, std::size_t offset, std::size_t nbVertices,
+                                          std::size_t stride, std::vector<std::uint32_t>& indices) const {
+    std::size_t tableSize = 1;
+    while (tableSize < 2 * nbVertices) { tableSize <<= 1; }
+    std::vector<std::uint32_t> table(tableSize, 0); // welded index + 1, 0 means empty slot
+    indices.resize(nbVertices);
+
+    // Welded vertices are compacted in place: the write position never passes the read position
+    char* vertices = array.data() + offset;
+    std::uint32_t nbWelded = 0;
+    for (std::size_t v = 0; v < nbVertices; ++v) {
+      const char* vertex = vertices + v * stride;
+      std::size_t slot = hash_vertex(vertex, stride) & (tableSize - 1);
+      while (table[slot] != 0 &&
+             std::memcmp(vertex, vertices + (table[slot] - 1) * stride, stride) != 0) {
+        slot = (slot + 1) & (tableSize - 1);
+      }
+
+      if (table[slot] == 0) {
+        std::memmove(vertices + nbWelded * stride, vertex, stride);
+        table[slot] = ++nbWelded;
+      }
+      indices[v] = table[slot] - 1;
+    }
+    return nbWelded;
+  }
+
+  // 16-bit indices when every index is below 65536 (nbVertices).
+  // The element buffer binding is part of the VAO state.
+  void Basic_Viewer::upload_indices(int i, int vao, const std::vector<std::uint32_t>& indices, std::size_t nbVertices){
+    if (nbVertices <= std::numeric_limits<std::uint16_t>::max() + 1u) {
+      std::vector<std::uint16_t> indices16(indices.begin(), indices.end());
+      const std::size_t indexBytes = indices16.size() * sizeof(std::uint16_t);
+      upload_buffer(i, GL_ELEMENT_ARRAY_BUFFER, indexBytes, 0, indexBytes, indices16.data());
+      m_element_type[vao] = GL_UNSIGNED_SHORT;
+    } else {
+      const std::size_t indexBytes = indices.size() * sizeof(std::uint32_t);
+      upload_buffer(i, GL_ELEMENT_ARRAY_BUFFER, indexBytes, 0, indexBytes, indices.data());
+      m_element_type[vao] = GL_UNSIGNED_INT;
+    }
+  }
+
+  void Basic_Viewer::load_indexed_faces(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> attributes){
+    // Faces are always welded from the interleaved layout: a vertex is shared only if
+    // its position, normal (flat or smooth, whichever is loaded) and color are identical
+    // (after quantization with compact vertices).
+    // Any change in the source arrays requires welding the whole category again.
+    // Welding keeps the order of the triangles: chunks are also ranges of the element buffer.
+    auto& array = m_interleaved_array;
+    const std::size_t stride = interleave(attributes, array, vertex_order(vao));
+
+    std::vector<std::uint32_t> indices;
+    const std::size_t nbWelded = weld_vertices(array, 0, array.size() / stride, stride, indices);
+    array.resize(nbWelded * stride);
+
+    const std::size_t vertexBytes = array.size();
+    upload_buffer(bufn++, GL_ARRAY_BUFFER, vertexBytes, 0, vertexBytes, array.data());
+    set_interleaved_attributes(attributes);
+
+    m_element_count[vao] = static_cast<GLsizei>(indices.size());
+    upload_indices(bufn++, vao, indices, nbWelded);
+  }
+
+  void Basic_Viewer::load_faces(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> attributes){
+    // Faces are drawn from the levels of detail, the face VAOs are the last ones using bufn
+    if (use_lod()) return;
+
+    if (use_indexed_faces()) {
+      if (!is_any_dirty(attributes)) {
+        bufn += 2;
+        return;
+      }
+
+      update_chunks(vao, attributes.begin()->gsEnum);
+      load_indexed_faces(bufn, vao, attributes);
+      return;
+    }
+
+    load_vertices(bufn, vao, attributes);
+  }
+
+  // Mono VAO vao and colored VAO vao+1 of a category
+  void Basic_Viewer::load_category(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> mono,
+                                   std::initializer_list<Vertex_attribute> colored){
+    if (use_multi_draw_indirect()) {
+      load_merged_category(bufn, vao, mono, colored);
+      return;
+    }
+
+    const bool faces = vao == VAO_MONO_FACES;
+
+    // The mono VAO may still have the color attribute of a merged category
+    glBindVertexArray(m_vao[vao]);
+    glDisableVertexAttribArray(std::prev(colored.end())->location);
+    set_draw_params_attribute(false);
+    if (faces) { load_faces(bufn, vao, mono); }
+    else       { load_vertices(bufn, vao, mono); }
+
+    glBindVertexArray(m_vao[vao + 1]);
+    set_draw_params_attribute(false);
+    if (faces) { load_faces(bufn, vao + 1, colored); }
+    else       { load_vertices(bufn, vao + 1, colored); }
+  }
+
+  // Mono and colored vertices of a category in the buffers of the VAO vao: mono vertices first, packed like
+  // the colored ones with a zero color (the color source of each draw selects mono_color in the shaders).
+  // Chunks and octrees stay per VAO, m_merged_first gives the offset of each part.
+  void Basic_Viewer::load_merged_category(unsigned int& bufn, int vao, std::initializer_list<Vertex_attribute> mono,
+                                          std::initializer_list<Vertex_attribute> colored){
+    // Faces are drawn from the levels of detail, the face VAOs are the last ones using bufn
+    if (vao == VAO_MONO_FACES && use_lod()) return;
+
+    const bool indexed = is_indexed(vao);
+    if (!is_any_dirty(mono) && !is_any_dirty(colored)) {
+      bufn += indexed ? 2 : 1;
+      return;
+    }
+
+    const bool monoReordered = update_chunks(vao, mono.begin()->gsEnum);
+    const bool coloredReordered = update_chunks(vao + 1, colored.begin()->gsEnum);
+
+    std::vector<const float*> monoSources, coloredSources;
+    for (const Vertex_attribute& attribute : colored) {
+      coloredSources.push_back(m_scene->get_array_of_index(attribute.gsEnum).data());
+      monoSources.push_back(nullptr);
+      for (const Vertex_attribute& monoAttribute : mono) {
+        if (monoAttribute.location == attribute.location) {
+          monoSources.back() = m_scene->get_array_of_index(monoAttribute.gsEnum).data();
+        }
+      }
+    }
+
+    const std::size_t nbMono = m_scene->number_of_elements(mono.begin()->gsEnum);
+    const std::size_t nbColored = m_scene->number_of_elements(colored.begin()->gsEnum);
+    const std::size_t stride = vertex_size(colored);
+    const std::size_t elementSize = 3 * sizeof(float);
+    auto& array = m_interleaved_array;
+
+    // Without welding, the mono vertices are at the start of the buffer and the colored ones right after them,
+    // each part in the order of its chunks. While both parts keep their size and order, the dirty vertices of
+    // each part are packed again and written in place.
+    if (!indexed && !monoReordered && !coloredReordered && m_merged_first[vao + 1] == nbMono &&
+        m_array_states[mono.begin()->gsEnum].uploaded_size == nbMono * elementSize &&
+        m_array_states[colored.begin()->gsEnum].uploaded_size == nbColored * elementSize &&
+        (nbMono + nbColored) * stride <= m_buffer_capacity[bufn]) {
+      glBindVertexArray(m_vao[vao]);
+      const std::pair<int, const float* const*> parts[] = {{vao, monoSources.data()}, {vao + 1, coloredSources.data()}};
+      for (const auto& part : parts) {
+        const std::pair<std::size_t, std::size_t> range = 
+          packed_range(part.first, dirty_vertices(part.first == vao ? mono : colored));
+        if (range.first >= range.second) continue;
+
+        array.clear();
+        pack_vertices(colored, part.second, vertex_order(part.first), range.first, range.second, array);
+        upload_buffer(bufn, GL_ARRAY_BUFFER, (nbMono + nbColored) * stride,
+                      (m_merged_first[part.first] + range.first) * stride, array.size(), array.data());
+      }
+      ++bufn;
+      set_interleaved_attributes(colored);
+      set_draw_params_attribute(true);
+      return;
+    }
+
+    // Otherwise the whole category is packed again
+    array.clear();
+    pack_vertices(colored, monoSources.data(), vertex_order(vao), 0, nbMono, array);
+    pack_vertices(colored, coloredSources.data(), vertex_order(vao + 1), 0, nbColored, array);
+
+    // Both parts are welded on their own, their indices are relative to the base vertex of their draws
+    std::vector<std::uint32_t> indices, coloredIndices;
+    std::size_t nbMonoVertices = nbMono, nbColoredVertices = nbColored;
+    if (indexed) {
+      nbMonoVertices = weld_vertices(array, 0, nbMono, stride, indices);
+      nbColoredVertices = weld_vertices(array, nbMono * stride, nbColored, stride, coloredIndices);
+      std::memmove(array.data() + nbMonoVertices * stride, array.data() + nbMono * stride, nbColoredVertices * stride);
+      array.resize((nbMonoVertices + nbColoredVertices) * stride);
+    }
+    m_merged_first[vao] = 0;
+    m_merged_first[vao + 1] = nbMonoVertices;
+
+    glBindVertexArray(m_vao[vao]);
+    upload_buffer(bufn++, GL_ARRAY_BUFFER, array.size(), 0, array.size(), array.data());
+    set_interleaved_attributes(colored);
+
+    if (indexed) {
+      m_first_index[vao] = 0;
+      m_first_index[vao + 1] = indices.size();
+      m_element_count[vao] = static_cast<GLsizei>(indices.size());
+      m_element_count[vao + 1] = static_cast<GLsizei>(coloredIndices.size());
+
+      indices.insert(indices.end(), coloredIndices.begin(), coloredIndices.end());
+      upload_indices(bufn++, vao, indices, std::max(nbMonoVertices, nbColoredVertices));
+      m_element_type[vao + 1] = m_element_type[vao];
+    }
+
+    set_draw_params_attribute(true);
+  }
+
+  // Per draw parameters of the bound VAO: read from the parameters of the indirect commands (one per instance,
+  // indexed by their base instance), or a constant attribute (see render_scene) when disabled
+  void Basic_Viewer::set_draw_params_attribute(bool enabled){
+    if (!enabled) {
+      glDisableVertexAttribArray(DRAW_PARAMS_LOCATION);
+      return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_draw_params_buffer);
+    glVertexAttribPointer(DRAW_PARAMS_LOCATION, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glVertexAttribDivisor(DRAW_PARAMS_LOCATION, 1);
+    glEnableVertexAttribArray(DRAW_PARAMS_LOCATION);
+  }
+
+  // Every level of every chunk in one vertex buffer and one element buffer,
+  // packed like the colored faces of the scene (compact vertices included)
+  void Basic_Viewer::load_lod(){
+    const std::initializer_list<Vertex_attribute> attributes = {{0, Graphics_scene::POS_COLORED_FACES},
+                                                                 {1, Graphics_scene::SMOOTH_NORMAL_COLORED_FACES},
+                                                                 {2, Graphics_scene::COLOR_FACES}};
+    const float* sources[] = {m_lod->positions().data(), m_lod->normals().data(), m_lod->colors().data()};
+
+    auto& array = m_interleaved_array;
+    array.clear();
+    pack_vertices(attributes, sources, {}, 0, m_lod->positions().size() / 3, array);
+
+    glBindVertexArray(m_vao[VAO_LOD_FACES]);
+    upload_buffer(LOD_VERTEX_BUFFER, GL_ARRAY_BUFFER, array.size(), 0, array.size(), array.data());
+    set_interleaved_attributes(attributes);
+
+    const std::size_t indexBytes = m_lod->indices().size() * sizeof(std::uint32_t);
+    upload_buffer(LOD_INDEX_BUFFER, GL_ELEMENT_ARRAY_BUFFER, indexBytes, 0, indexBytes, m_lod->indices().data());
+    set_draw_params_attribute(use_multi_draw_indirect());
+
+    m_is_lod_loaded = true;
+  }
+
+  // The direct mesh writes its vertices and indices into the mapped storage of its buffers,
+  // or into a staging array if they cannot be mapped
+  void Basic_Viewer::load_direct_mesh(){
+    const std::size_t vertexBytes = m_direct_mesh->nb_vertices * m_direct_mesh->vertex_floats() * sizeof(float);
+    const std::size_t indexBytes = 3 * m_direct_mesh->nb_triangles * sizeof(std::uint32_t);
+
+    glBindVertexArray(m_vao[VAO_DIRECT_FACES]);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[DIRECT_VERTEX_BUFFER]);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffers[DIRECT_INDEX_BUFFER]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+    m_buffer_capacity[DIRECT_VERTEX_BUFFER] = vertexBytes;
+    m_buffer_capacity[DIRECT_INDEX_BUFFER] = indexBytes;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    float* vertices = nullptr;
+    std::uint32_t* indices = nullptr;
+    if (glMapBufferRange != nullptr) {
+      vertices = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes, flags));
+      indices = static_cast<std::uint32_t*>(glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, flags));
+    }
+
+    bool loaded = true;
+    if (vertices != nullptr && indices != nullptr) {
+      m_direct_mesh->write(vertices, indices);
+      // The storage may be lost while mapped (GL_FALSE), it is written again at the next load
+      loaded = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+      loaded = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE && loaded;
+    } else {
+      if (vertices != nullptr) { glUnmapBuffer(GL_ARRAY_BUFFER); }
+      if (indices != nullptr) { glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER); }
+
+      std::vector<float> stagingVertices(vertexBytes / sizeof(float));
+      std::vector<std::uint32_t> stagingIndices(indexBytes / sizeof(std::uint32_t));
+      m_direct_mesh->write(stagingVertices.data(), stagingIndices.data());
+      glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, stagingVertices.data());
+      glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, stagingIndices.data());
+    }
+
+    if (m_direct_mesh->colored()) {
+      set_interleaved_attributes({{0, Graphics_scene::POS_COLORED_FACES},
+                                  {1, Graphics_scene::SMOOTH_NORMAL_COLORED_FACES},
+                                  {2, Graphics_scene::COLOR_FACES}});
+    } else {
+      set_interleaved_attributes({{0, Graphics_scene::POS_MONO_FACES},
+                                  {1, Graphics_scene::SMOOTH_NORMAL_MONO_FACES}});
+    }
+    set_draw_params_attribute(false);
+
+    m_is_direct_mesh_loaded = loaded;
+  }
+
+  void Basic_Viewer::init_buffers(){
+    glGenBuffers(NB_GL_BUFFERS, m_buffers);
+    glGenVertexArrays(NB_VAO_BUFFERS, m_vao); 
+    std::fill(std::begin(m_buffer_capacity), std::end(m_buffer_capacity), 0);
+
+    glGenBuffers(1, &m_draw_command_buffer);
+    glGenBuffers(1, &m_draw_params_buffer);
+    glGenBuffers(1, &m_frame_ubo);
+    m_uploaded_frame_block.clear();
+    m_draw_command_capacity = 0;
+    m_draw_params_capacity = 0;
+
+    std::fill(std::begin(m_dynamic_buffers), std::end(m_dynamic_buffers), 0);
+    std::fill(std::begin(m_dynamic_mapped), std::end(m_dynamic_mapped), nullptr);
+    std::fill(std::begin(m_dynamic_capacity), std::end(m_dynamic_capacity), 0);
+    std::fill(std::begin(m_dynamic_fences), std::end(m_dynamic_fences), nullptr);
+
+    // New GL names: nothing is uploaded yet
+    m_are_buffers_initialized = false;
+    m_is_scene_loaded = false;
+    m_is_lod_loaded = false;
+    m_is_direct_mesh_loaded = false;
+  }
+
+  void Basic_Viewer::load_scene()
+  {
+    unsigned int bufn = 0;
+
+    // Everything is uploaded again for a new scene or a new buffer layout, 
+    // otherwise only the arrays updated since the last call
+    if (!m_is_scene_loaded || !m_are_buffers_initialized) {
+      for (int i = 0; i < Graphics_scene::LAST_INDEX; ++i) {
+        mark_array_dirty(i);
+      }
+      m_is_lod_loaded = false;
+      m_is_direct_mesh_loaded = false;
+    }
+
+    if (m_compiled_compact_vertices != use_compact_vertices()) {
+      compile_shaders();
+    }
+
+    // Compact positions are relative to the bounding box, they are all quantized again when it changes
+    if (use_compact_vertices() && update_quantization_box()) {
+      for (int i = Graphics_scene::BEGIN_POS; i < Graphics_scene::END_POS; ++i) {
+        mark_array_dirty(i);
+      }
+      m_is_lod_loaded = false;
+    }
+
+    // 1) POINT SHADER
+    m_pl_shader.use();
+    load_category(bufn, VAO_MONO_POINTS, {{0, Graphics_scene::POS_MONO_POINTS}},
+                                         {{0, Graphics_scene::POS_COLORED_POINTS}, 
+                                          {1, Graphics_scene::COLOR_POINTS}});
+
+    // 2) SEGMENT SHADER
+    load_category(bufn, VAO_MONO_SEGMENTS, {{0, Graphics_scene::POS_MONO_SEGMENTS}},
+                                           {{0, Graphics_scene::POS_COLORED_SEGMENTS}, 
+                                            {1, Graphics_scene::COLOR_SEGMENTS}});
+
+    // 3) RAYS SHADER
+    load_category(bufn, VAO_MONO_RAYS, {{0, Graphics_scene::POS_MONO_RAYS}},
+                                       {{0, Graphics_scene::POS_COLORED_RAYS}, 
+                                        {1, Graphics_scene::COLOR_RAYS}});
+  
+    // 4) LINES SHADER
+    load_category(bufn, VAO_MONO_LINES, {{0, Graphics_scene::POS_MONO_LINES}},
+                                        {{0, Graphics_scene::POS_COLORED_LINES}, 
+                                         {1, Graphics_scene::COLOR_LINES}});
+
+    // 5) FACE SHADER
+    // Faces left out of the scene for the levels of detail, which are not drawn in this context
+    if (m_lod_fallback_faces && !use_lod()) {
+      Faces_callback addFaces = std::move(m_lod_fallback_faces);
+      m_lod_fallback_faces = nullptr;
+      addFaces();
+      for (int i : {Graphics_scene::POS_MONO_FACES, Graphics_scene::POS_COLORED_FACES, Graphics_scene::COLOR_FACES,
+                    Graphics_scene::SMOOTH_NORMAL_MONO_FACES, Graphics_scene::SMOOTH_NORMAL_COLORED_FACES,
+                    Graphics_scene::FLAT_NORMAL_MONO_FACES, Graphics_scene::FLAT_NORMAL_COLORED_FACES}) {
+        mark_array_dirty(i);
+      }
+    }
+
+    m_face_shader.use();
+    load_category(bufn, VAO_MONO_FACES, {{0, Graphics_scene::POS_MONO_FACES}, 
+                                         {1, use_flat_normal_arrays() ? Graphics_scene::FLAT_NORMAL_MONO_FACES 
+                                                                      : Graphics_scene::SMOOTH_NORMAL_MONO_FACES}},
+                                        {{0, Graphics_scene::POS_COLORED_FACES}, 
+                                         {1, use_flat_normal_arrays() ? Graphics_scene::FLAT_NORMAL_COLORED_FACES 
+                                                                      : Graphics_scene::SMOOTH_NORMAL_COLORED_FACES},
+                                         {2, Graphics_scene::COLOR_FACES}});
+
+    // 5.1) Levels of detail
+    if (use_lod() && !m_is_lod_loaded) {
+      load_lod();
+    }
+
+    // 5.2) Direct mesh
+    if (use_direct_mesh() && !m_is_direct_mesh_loaded) {
+      load_direct_mesh();
+    }
+
+    // 6) clipping plane shader (its size only depends on the scene bounding box)
+    if (m_is_opengl_4_3 && !m_is_scene_loaded) {
+      generate_clipping_plane();
+      glBindVertexArray(m_vao[VAO_CLIPPING_PLANE]);
+      load_buffer(CLIPPING_PLANE_BUFFER, 0, m_array_for_clipping_plane, 3);
+    }
 
+    // Built once the stream is finished, in the background when only the pick callback needs them
+    if (!is_streaming() && (m_picking || m_pick_callback)) {
+      update_pick_bvhs(m_picking);
+    }
 
-    m_face_shader = Shader::loadShader(face_vert, face_frag, "FACE");
-    m_pl_shader = Shader::loadShader(pl_vert, pl_frag, "PL");
-    m_plane_shader = Shader::loadShader(plane_vert, plane_frag, "PLANE");
+    clear_dirty_arrays();
+    m_are_buffers_initialized = true;
+    m_is_scene_loaded = true;
   }
 
-  void Basic_Viewer::load_buffer(int i, int location, const std::vector<float>& vector, int dataCount){
-    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
-
-    glBufferData(GL_ARRAY_BUFFER, vector.size() * sizeof(float), vector.data(), GL_STATIC_DRAW);
+  // Builds the BVHs of the points, segments and faces of a new scene or of resized arrays,
+  // refits them when only their positions changed. Without wait, the builds are started in the
+  // background and false is returned until they are done.
+  bool Basic_Viewer::update_pick_bvhs(bool wait) {
+    static const int arrays[][2] = { // position array, vertices per primitive
+      {Graphics_scene::POS_MONO_POINTS, 1}, {Graphics_scene::POS_COLORED_POINTS, 1},
+      {Graphics_scene::POS_MONO_SEGMENTS, 2}, {Graphics_scene::POS_COLORED_SEGMENTS, 2},
+      {Graphics_scene::POS_MONO_FACES, 3}, {Graphics_scene::POS_COLORED_FACES, 3}
+    };
+
+    if (m_pick_builds.valid() && 
+        (wait || m_pick_builds.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+      for (Pick_build& build : m_pick_builds.get()) {
+        const Pick_bvh& built = build.target;
+        if (built.scene == m_scene && built.version == m_array_states[build.gsEnum].version && 
+            built.size == m_scene->get_array_of_index(build.gsEnum).size()) {
+          m_pick_bvhs[build.gsEnum] = std::move(build.target);
+        }
+      }
+    }
 
-    glVertexAttribPointer(location, dataCount, GL_FLOAT, GL_FALSE, dataCount * sizeof(float), nullptr);
+    bool ready = true;
+    std::vector<Pick_build> builds;
+    for (const auto& array : arrays) {
+      const std::vector<float>& positions = m_scene->get_array_of_index(array[0]);
+      const std::size_t version = m_array_states[array[0]].version;
+      Pick_bvh& target = m_pick_bvhs[array[0]];
+      if (target.scene == m_scene && target.size == positions.size()) {
+        if (target.version == version) continue;
+        target.bvh.refit(positions.data());
+      } else if (!wait) {
+        // one build at a time, the arrays modified meanwhile are built by the next one
+        if (!m_pick_builds.valid()) {
+          builds.push_back({array[0], array[1], positions, {Bvh(), m_scene, version, positions.size()}});
+        }
+        ready = false;
+        continue;
+      } else {
+        target.bvh.build(positions.data(), positions.size() / (3 * array[1]), array[1], BVH_LEAF_SIZE, BVH_PARALLEL_SIZE);
+      }
+      target.scene = m_scene;
+      target.version = version;
+      target.size = positions.size();
+    }
 
-    glEnableVertexAttribArray(location);
+    if (!builds.empty()) {
+      // The copies are released once built, refit() is given the positions of the scene
+      m_pick_builds = std::async(std::launch::async, [builds = std::move(builds)]() mutable {
+        for (Pick_build& build : builds) {
+          build.target.bvh.build(build.positions.data(), build.positions.size() / (3 * build.primitiveSize), 
+                                 build.primitiveSize, BVH_LEAF_SIZE, BVH_PARALLEL_SIZE);
+          std::vector<float>().swap(build.positions);
+        }
+        return std::move(builds);
+      });
+    }
+    return ready;
   }
 
+  Pick_result Basic_Viewer::pick() {
+    return pick(get_cursor(), m_pick_radius);
+  }
 
-  void Basic_Viewer::load_buffer(int i, int location, int gsEnum, int dataCount){ 
-    const std::vector<float>& vector = m_scene->get_array_of_index(gsEnum);
-    load_buffer(i, location, vector, dataCount);
+  Pick_result Basic_Viewer::pick(const vec2f& cursor, float pickRadius) {
+    return pick(cursor, pickRadius, true);
   }
 
-  void Basic_Viewer::init_buffers(){
-    if (m_are_buffers_initialized){
-      glGenBuffers(NB_GL_BUFFERS, m_buffers);
-      glGenVertexArrays(NB_VAO_BUFFERS, m_vao); 
-      m_are_buffers_initialized = true;
+  Pick_result Basic_Viewer::pick(const vec2f& cursor, float pickRadius, bool wait) {
+    Pick_result result;
+    if (m_scene == nullptr) return result;
+    if (!update_pick_bvhs(wait)) return result;
+    update_clip_distances();
+
+    const mat4f mvp = m_cam_projection * lookAt(m_cam_position, m_cam_position + m_cam_forward, vec3f(0,1,0)) * m_scene_rotation;
+    const mat4f inverse = mvp.inverse();
+    // Screen coordinates of the cursor, m_window_size is the size of the framebuffer (larger on HiDPI displays)
+    vec2f size = m_window_size.cast<float>();
+    if (m_window != nullptr) {
+      int width = 0, height = 0;
+      glfwGetWindowSize(m_window, &width, &height);
+      if (width > 0 && height > 0) { size = vec2f(width, height); }
+    }
+    auto unproject = [&](const vec2f& pixel, float depth) {
+      const vec4f p = inverse * vec4f(2.f * pixel.x() / size.x() - 1.f, 1.f - 2.f * pixel.y() / size.y(), depth, 1.f);
+      return vec3f(p.head<3>() / p.w());
+    };
+    auto pixel_distance = [&](const vec3f& p) {
+      const vec4f c = mvp * vec4f(p.x(), p.y(), p.z(), 1.f);
+      if (c.w() <= 0.f) return std::numeric_limits<float>::infinity();
+      const vec2f pixel(0.5f * (c.x() / c.w() + 1.f) * size.x(), 0.5f * (1.f - c.y() / c.w()) * size.y());
+      return (pixel - cursor).norm();
+    };
+    // Hidden by the clipping plane (only its solid half is drawn for faces, or everything is in solid half only mode),
+    // the clip box or the clip planes
+    auto clipped = [&](const vec3f& p, bool isFace) {
+      for (std::size_t i = 0; i < m_clip_distances.size(); ++i) {
+        if (i == 0 && (m_use_clipping_plane == CLIPPING_PLANE_OFF || 
+                       (!isFace && m_use_clipping_plane != CLIPPING_PLANE_SOLID_HALF_ONLY))) continue;
+        if (m_clip_distances[i].dot(vec4f(p.x(), p.y(), p.z(), 1.f)) < 0.f) return true;
+      }
+      return false;
+    };
+
+    // Ray from the near plane (t = 0) to the far plane (t = 1) through the cursor, the pixel radius at 
+    // the distance t is nearRadius + t * (farRadius - nearRadius)
+    const vec3f origin = unproject(cursor, -1.f);
+    const vec3f direction = unproject(cursor, 1.f) - origin;
+    const float directionNorm2 = direction.squaredNorm();
+    const float nearRadius = (unproject(cursor + vec2f(pickRadius, 0.f), -1.f) - origin).norm();
+    const float farRadius = (unproject(cursor + vec2f(pickRadius, 0.f), 1.f) - origin - direction).norm();
+    if (!(directionNorm2 > 0.f)) return result;
+
+    auto vertex = [&](const std::vector<float>& positions, std::size_t v) {
+      return vec3f(positions[3*v], positions[3*v+1], positions[3*v+2]);
+    };
+
+    // Nearest face (Moller-Trumbore, both sides)
+    float tFace = 1.f;
+    if (m_draw_faces) {
+      for (int gsEnum : {Graphics_scene::POS_MONO_FACES, Graphics_scene::POS_COLORED_FACES}) {
+        const std::vector<float>& positions = m_scene->get_array_of_index(gsEnum);
+        m_pick_bvhs[gsEnum].bvh.traverse(origin, direction, 0.f, tFace, [&](std::uint32_t triangle) {
+          const vec3f a = vertex(positions, 3*triangle), b = vertex(positions, 3*triangle+1), c = vertex(positions, 3*triangle+2);
+          const vec3f ab = b - a, ac = c - a;
+          const vec3f p = direction.cross(ac);
+          const float det = ab.dot(p);
+          if (std::abs(det) < std::numeric_limits<float>::min()) return;
+
+          const vec3f ao = origin - a;
+          const float u = ao.dot(p) / det;
+          if (u < 0.f || u > 1.f) return;
+          const vec3f q = ao.cross(ab);
+          const float v = direction.dot(q) / det;
+          if (v < 0.f || u + v > 1.f) return;
+          const float t = ac.dot(q) / det;
+          if (t < 0.f || t > tFace) return;
+
+          const vec3f hit = origin + t * direction;
+          if (clipped(hit, true)) return;
+          tFace = t;
+          result = {gsEnum, triangle, hit, 0.f};
+        });
+      }
     }
-  }
 
-  void Basic_Viewer::load_scene()
-  {
-    unsigned int bufn = 0;
+    // Vertices and edges in front of the face, or behind it by less than the pick radius
+    const float tMax = std::min(1.f, tFace + (nearRadius + tFace * (farRadius - nearRadius)) / std::sqrt(directionNorm2));
+    const float expansion = nearRadius + tMax * (farRadius - nearRadius);
+    Pick_result nearest;
+    nearest.pixel_distance = pickRadius;
+    float tNearest = tMax;
+    auto candidate = [&](int gsEnum, std::uint32_t element, const vec3f& p) {
+      const float t = (p - origin).dot(direction) / directionNorm2;
+      if (t < 0.f || t > tMax) return;
+      const float d = pixel_distance(p);
+      if (d > nearest.pixel_distance || (d == nearest.pixel_distance && t >= tNearest) || clipped(p, false)) return;
+      nearest = {gsEnum, element, p, d};
+      tNearest = t;
+    };
+
+    if (m_draw_vertices) {
+      for (int gsEnum : {Graphics_scene::POS_MONO_POINTS, Graphics_scene::POS_COLORED_POINTS}) {
+        const std::vector<float>& positions = m_scene->get_array_of_index(gsEnum);
+        m_pick_bvhs[gsEnum].bvh.traverse(origin, direction, expansion, tMax, [&](std::uint32_t point) {
+          candidate(gsEnum, point, vertex(positions, point));
+        });
+      }
+      if (nearest) return nearest;
+    }
 
-    // 1) POINT SHADER
+    if (m_draw_edges) {
+      for (int gsEnum : {Graphics_scene::POS_MONO_SEGMENTS, Graphics_scene::POS_COLORED_SEGMENTS}) {
+        const std::vector<float>& positions = m_scene->get_array_of_index(gsEnum);
+        m_pick_bvhs[gsEnum].bvh.traverse(origin, direction, expansion, tMax, [&](std::uint32_t segment) {
+          // Point of the segment closest to the ray
+          const vec3f a = vertex(positions, 2*segment), u = vertex(positions, 2*segment+1) - a;
+          const vec3f w = a - origin;
+          const float uu = u.dot(u), ud = u.dot(direction), uw = u.dot(w), dw = direction.dot(w);
+          const float denominator = uu * directionNorm2 - ud * ud;
+          const float s = denominator > 0.f ? std::clamp((ud * dw - directionNorm2 * uw) / denominator, 0.f, 1.f) : 0.f;
+          candidate(gsEnum, segment, a + s * u);
+        });
+      }
+      if (nearest) return nearest;
+    }
 
-    // 1.1) Mono points
-    m_pl_shader.use();
-    glBindVertexArray(m_vao[VAO_MONO_POINTS]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_MONO_POINTS, 3);
+    return result;
+  }
 
-    // 1.2) Color points
-    glBindVertexArray(m_vao[VAO_COLORED_POINTS]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_COLORED_POINTS, 3);      
-    load_buffer(bufn++, 1, Graphics_scene::COLOR_POINTS, 3);      
+  void Basic_Viewer::dynamic_geometry(bool b, Dynamic_positions_callback callback) {
+    m_dynamic_geometry = b;
+    m_dynamic_callback = callback;
+    m_are_buffers_initialized = false;
+    redraw();
+  }
 
-    // 2) SEGMENT SHADER
+  // (Re)allocates the position ring of one array: DYNAMIC_RING_SIZE segments of capacity positions.
+  // Storage is immutable with glBufferStorage, so growing means a new buffer.
+  void Basic_Viewer::allocate_dynamic_buffer(int gsEnum, std::size_t capacity) {
+    const std::size_t segmentBytes = capacity * 3 * sizeof(float);
+    const std::size_t totalBytes = segmentBytes * DYNAMIC_RING_SIZE;
+
+    if (m_dynamic_buffers[gsEnum] != 0) {
+      // The GPU may still read from the old ring
+      glFinish();
+      glBindBuffer(GL_ARRAY_BUFFER, m_dynamic_buffers[gsEnum]);
+      if (m_dynamic_mapped[gsEnum] != nullptr) { glUnmapBuffer(GL_ARRAY_BUFFER); }
+      glDeleteBuffers(1, &m_dynamic_buffers[gsEnum]);
+    }
+
+    glGenBuffers(1, &m_dynamic_buffers[gsEnum]);
+    glBindBuffer(GL_ARRAY_BUFFER, m_dynamic_buffers[gsEnum]);
 
-    // 2.1) Mono segments
-    glBindVertexArray(m_vao[VAO_MONO_SEGMENTS]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_MONO_SEGMENTS, 3);      
+    if (m_has_buffer_storage) {
+      const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      glBufferStorage(GL_ARRAY_BUFFER, totalBytes, nullptr, flags);
+      m_dynamic_mapped[gsEnum] = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, totalBytes, flags));
+    } else {
+      glBufferData(GL_ARRAY_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+      m_dynamic_mapped[gsEnum] = nullptr;
+    }
 
-    // 2.2) Colored segments
-    glBindVertexArray(m_vao[VAO_COLORED_SEGMENTS]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_COLORED_SEGMENTS, 3);      
-    load_buffer(bufn++, 1, Graphics_scene::COLOR_SEGMENTS, 3);   
+    m_dynamic_capacity[gsEnum] = capacity;
+  }
 
-    // 3) RAYS SHADER
+  void Basic_Viewer::update_dynamic_geometry() {
+    m_dynamic_segment = (m_dynamic_segment + 1) % DYNAMIC_RING_SIZE;
+    const unsigned int segment = m_dynamic_segment;
+
+    // Wait until the GPU is done with the frame that used this segment DYNAMIC_RING_SIZE frames ago
+    GLsync& fence = m_dynamic_fences[segment];
+    if (fence != nullptr) {
+      // The thread sleeps in the driver. If the fence never signals (lost context...), wait for everything.
+      const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, DYNAMIC_WAIT_TIMEOUT);
+      if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+        glFinish();
+      }
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
 
-    // 2.1) Mono segments
-    glBindVertexArray(m_vao[VAO_MONO_RAYS]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_MONO_RAYS, 3);      
+    for (int i = Graphics_scene::BEGIN_POS; i < Graphics_scene::END_POS; ++i) {
+      const std::size_t nbElements = m_scene->number_of_elements(i);
+      if (nbElements == 0) continue;
 
-    // 2.2) Colored segments
-    glBindVertexArray(m_vao[VAO_COLORED_RAYS]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_COLORED_RAYS, 3);      
-    load_buffer(bufn++, 1, Graphics_scene::COLOR_RAYS, 3);   
-  
-    // 4) LINES SHADER
+      if (nbElements > m_dynamic_capacity[i]) {
+        allocate_dynamic_buffer(i, nbElements + nbElements / 2);
+      }
 
-    // 2.1) Mono lines
-    glBindVertexArray(m_vao[VAO_MONO_LINES]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_MONO_LINES, 3);      
+      const std::size_t segmentOffset = segment * m_dynamic_capacity[i] * 3;
 
-    // 2.2) Colored lines
-    glBindVertexArray(m_vao[VAO_COLORED_LINES]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_COLORED_LINES, 3);      
-    load_buffer(bufn++, 1, Graphics_scene::COLOR_LINES, 3);   
+      float* positions;
+      if (m_dynamic_mapped[i] != nullptr) {
+        positions = m_dynamic_mapped[i] + segmentOffset;
+      } else {
+        m_dynamic_staging.resize(nbElements * 3);
+        positions = m_dynamic_staging.data();
+      }
 
-    // 5) FACE SHADER
+      if (m_dynamic_callback) {
+        m_dynamic_callback(i, positions, nbElements);
+      } else {
+        const std::vector<float>& array = m_scene->get_array_of_index(i);
+        std::copy(array.begin(), array.begin() + nbElements * 3, positions);
+      }
 
-    // 5.1) Mono faces
-    m_face_shader.use();
-    glBindVertexArray(m_vao[VAO_MONO_FACES]);
-    load_buffer(bufn++, 0, Graphics_scene::POS_MONO_FACES, 3);
-    if (m_flat_shading) {
-      load_buffer(bufn++, 1, Graphics_scene::FLAT_NORMAL_MONO_FACES, 3);
-    } else {
-      load_buffer(bufn++, 1, Graphics_scene::SMOOTH_NORMAL_MONO_FACES, 3);
-    }
+      glBindBuffer(GL_ARRAY_BUFFER, m_dynamic_buffers[i]);
+      if (m_dynamic_mapped[i] == nullptr) {
+        // Fallback: regular upload in the segment, no persistent mapping
+        glBufferSubData(GL_ARRAY_BUFFER, segmentOffset * sizeof(float), nbElements * 3 * sizeof(float), positions);
+      }
 
-    // 5.2) Colored faces
-    glBindVertexArray(m_vao[VAO_COLORED_FACES]); 
-    load_buffer(bufn++, 0, Graphics_scene::POS_COLORED_FACES, 3);
-    if (m_flat_shading) {
-      load_buffer(bufn++, 1, Graphics_scene::FLAT_NORMAL_COLORED_FACES, 3);
-    } else {
-      load_buffer(bufn++, 1, Graphics_scene::SMOOTH_NORMAL_COLORED_FACES, 3);
+      // POS_* arrays and VAO_* categories are declared in the same order
+      glBindVertexArray(m_vao[VAO_MONO_POINTS + (i - Graphics_scene::BEGIN_POS)]);
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<void*>(segmentOffset * sizeof(float)));
+      glEnableVertexAttribArray(0);
     }
-    load_buffer(bufn++, 2, Graphics_scene::COLOR_FACES, 3);
+  }
 
-    // 6) clipping plane shader
-    if (m_is_opengl_4_3) {
-      generate_clipping_plane();
-      glBindVertexArray(m_vao[VAO_CLIPPING_PLANE]);
-      load_buffer(bufn++, 0, m_array_for_clipping_plane, 3);
+  void Basic_Viewer::end_dynamic_frame() {
+    if (m_has_buffer_storage) {
+      m_dynamic_fences[m_dynamic_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
     }
-
-    m_are_buffers_initialized = true;
   }
 
   CGAL::Plane_3<Basic_Viewer::Local_kernel> Basic_Viewer::clipping_plane() const
@@ -290,14 +1752,56 @@ namespace CGAL::GLFW {
     m_model_view = lookAt(m_cam_position, m_cam_position + m_cam_forward, vec3f(0,1,0)) * m_scene_rotation;
 
     m_mvp = m_cam_projection * m_model_view;
+    update_frustum();
+
+    m_eye = (m_model_view.inverse() * vec4f(0, 0, 0, 1)).head<3>();
+    m_pixels_per_unit = 0.5f * m_window_size.y() * m_cam_projection(1, 1);
 
     // ================================================================
 
+    update_clip_distances();
+    if (m_is_opengl_4_3) {
+      update_frame_uniforms();
+      return;
+    }
     set_face_uniforms();
     set_pl_uniforms();
-    set_clipping_uniforms();
   }
 
+  // Gribb & Hartmann: planes of the clip space cube expressed in model space
+  void Basic_Viewer::update_frustum(){
+    for (int i = 0; i < 3; ++i) {
+      m_frustum_planes[2*i]   = (m_mvp.row(3) + m_mvp.row(i)).transpose();
+      m_frustum_planes[2*i+1] = (m_mvp.row(3) - m_mvp.row(i)).transpose();
+    }
+  }
+
+  // False when the box is outside the view frustum or fully clipped by one of the clip distances of the pass
+  bool Basic_Viewer::is_box_visible(const Eigen::AlignedBox3f& box) const {
+    auto isOutside = [&box](const vec4f& plane) {
+      // corner of the box the furthest along the plane normal
+      const vec3f p(plane.x() >= 0 ? box.max().x() : box.min().x(),
+                    plane.y() >= 0 ? box.max().y() : box.min().y(),
+                    plane.z() >= 0 ? box.max().z() : box.min().z());
+      return plane.head<3>().dot(p) + plane.w() < 0;
+    };
+
+    for (const vec4f& plane : m_frustum_planes) {
+      if (isOutside(plane)) return false;
+    }
+    for (const vec4f& plane : m_culling_planes) {
+      if (isOutside(plane)) return false;
+    }
+    return true;
+  }
+
+  // Pixels per model space unit at the point of box the closest to the camera
+  float Basic_Viewer::projection_scale(const Eigen::AlignedBox3f& box) const {
+    if (m_cam_mode == ORTHOGRAPHIC) return m_pixels_per_unit;
+    return m_pixels_per_unit / std::max(box.exteriorDistance(m_eye), std::numeric_limits<float>::epsilon());
+  }
+
+  // OpenGL 2.1 programs, which have no uniform block
   void Basic_Viewer::set_face_uniforms() {
     m_face_shader.use();
 
@@ -310,9 +1814,17 @@ namespace CGAL::GLFW {
     m_face_shader.setVec4f("light_amb", m_ambient.data());
     m_face_shader.setFloat("spec_power", m_shininess);    
 
+    m_face_shader.setFloat("flat_shading", m_flat_shading ? 1.f : 0.f);
+    m_face_shader.setFloat("normal_sign", m_inverse_normal ? -1.f : 1.f);
+
     m_face_shader.setVec4f("clipPlane", m_clip_plane.data());
     m_face_shader.setVec4f("pointPlane", m_point_plane.data());
     m_face_shader.setFloat("rendering_transparency", m_clipping_plane_rendering_transparency);
+
+    if (m_compiled_compact_vertices) {
+      m_face_shader.setVec3f("bbox_min", m_quantization_min.data());
+      m_face_shader.setVec3f("bbox_extent", m_quantization_extent.data());
+    }
   }
 
   void Basic_Viewer::set_pl_uniforms() {
@@ -322,40 +1834,173 @@ namespace CGAL::GLFW {
     m_pl_shader.setVec4f("pointPlane", m_point_plane.data());
     m_pl_shader.setMatrix4f("mvp_matrix", m_mvp.data());
     m_pl_shader.setFloat("point_size", m_size_points);
+    m_pl_shader.setFloat("pixels_per_unit", m_pixels_per_unit);
+
+    if (m_compiled_compact_vertices) {
+      m_pl_shader.setVec3f("bbox_min", m_quantization_min.data());
+      m_pl_shader.setVec3f("bbox_extent", m_quantization_extent.data());
+    }
+  }
+
+  // Fills the Frame_uniforms block, uploaded only when it changed since the last frame
+  void Basic_Viewer::update_frame_uniforms() {
+    Frame_uniforms u {};
+    auto copy = [](float* dst, const float* src, int n) { std::copy(src, src + n, dst); };
+    copy(u.mvp_matrix, m_mvp.data(), 16);
+    copy(u.mv_matrix, m_model_view.data(), 16);
+    copy(u.clipping_matrix, m_clipping_matrix.data(), 16);
+    copy(u.light_pos, m_light_position.data(), 4);
+    copy(u.light_diff, m_diffuse.data(), 4);
+    copy(u.light_spec, m_specular.data(), 4);
+    copy(u.light_amb, m_ambient.data(), 4);
+    copy(u.bbox_min, m_quantization_min.data(), 3);
+    copy(u.bbox_extent, m_quantization_extent.data(), 3);
+    u.spec_power = m_shininess;
+    u.flat_shading = m_flat_shading ? 1.f : 0.f;
+    u.normal_sign = m_inverse_normal ? -1.f : 1.f;
+    u.point_size = m_size_points;
+    u.pixels_per_unit = m_pixels_per_unit;
+    u.rendering_transparency = m_clipping_plane_rendering_transparency;
+    u.nb_clip_distances = static_cast<std::int32_t>(m_clip_distances.size());
+
+    const std::size_t planesSize = m_max_clip_distances * sizeof(vec4f);
+    m_frame_block.assign(sizeof(Frame_uniforms) + planesSize, 0);
+    std::memcpy(m_frame_block.data(), &u, sizeof(Frame_uniforms));
+    std::memcpy(m_frame_block.data() + sizeof(Frame_uniforms), m_clip_distances.data(), m_clip_distances.size() * sizeof(vec4f));
+
+    if (m_frame_block == m_uploaded_frame_block) return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frame_ubo);
+    if (m_frame_block.size() != m_uploaded_frame_block.size()) {
+      glBufferData(GL_UNIFORM_BUFFER, m_frame_block.size(), m_frame_block.data(), GL_DYNAMIC_DRAW);
+      glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_frame_ubo);
+    } else {
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, m_frame_block.size(), m_frame_block.data());
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_frame_block.swap(m_uploaded_frame_block);
   }
 
-  void Basic_Viewer::set_clipping_uniforms() {
+  // Model space planes of the hardware clip distances, inside is positive: the clipping plane, the faces 
+  // of the clip box then the clip planes, as many as the context supports
+  void Basic_Viewer::update_clip_distances() {
     m_point_plane = m_clipping_matrix * vec4f(0, 0, 0, 1);
     m_clip_plane = m_clipping_matrix * vec4f(0, 0, 1, 0);
-    m_plane_shader.use();
 
-    m_plane_shader.setMatrix4f("vp_matrix", m_mvp.data());
-    m_plane_shader.setMatrix4f("m_matrix", m_clipping_matrix.data());
+    m_clip_distances.clear();
+    m_clip_distances.push_back(vec4f(m_clip_plane.x(), m_clip_plane.y(), m_clip_plane.z(), 
+                                     -m_clip_plane.head<3>().dot(m_point_plane.head<3>())));
+    if (!m_is_opengl_4_3) return;
+
+    if (m_use_clip_box) {
+      // -1 <= (transform^-1 x)_i <= 1
+      const mat4f inverse = m_clip_box.inverse();
+      for (int i = 0; i < 3; ++i) {
+        m_clip_distances.push_back(vec4f(0, 0, 0, 1) - inverse.row(i).transpose());
+        m_clip_distances.push_back(vec4f(0, 0, 0, 1) + inverse.row(i).transpose());
+      }
+    }
+    for (const vec4f& plane : m_clip_planes) {
+      if (m_clip_distances.size() >= static_cast<std::size_t>(m_max_clip_distances)) break;
+      m_clip_distances.push_back(plane);
+    }
+  }
+
+  // Enables the clip distances of a pass of the face or the point and line programs, the clipping plane 
+  // only when drawing one of its halves. Chunks fully outside one of them are not drawn.
+  void Basic_Viewer::enable_clip_distances(RenderMode mode) {
+    m_culling_planes.clear();
+    if (!m_is_opengl_4_3) return;
+
+    for (std::size_t i = 0; i < m_clip_distances.size(); ++i) {
+      if (i == 0 && mode == DRAW_ALL) {
+        glDisable(GL_CLIP_DISTANCE0);
+        continue;
+      }
+
+      glEnable(GL_CLIP_DISTANCE0 + static_cast<GLenum>(i));
+      m_culling_planes.push_back(i == 0 && mode == DRAW_OUTSIDE_ONLY ? vec4f(-m_clip_distances[0]) : m_clip_distances[i]);
+    }
+  }
+
+  // Before the programs without clip distances
+  void Basic_Viewer::disable_clip_distances() {
+    m_culling_planes.clear();
+    if (!m_is_opengl_4_3) return;
+
+    for (int i = 0; i < m_max_clip_distances; ++i) {
+      glDisable(GL_CLIP_DISTANCE0 + static_cast<GLenum>(i));
+    }
   }
   
   void Basic_Viewer::render_scene()
   {
-    if(!m_is_scene_loaded) { load_scene(); }
+    Frame_profiler::Cpu_timer frameTimer(m_profiler, Frame_profiler::RENDER_SCENE);
+    m_profiler.begin_frame();
+
+    if(!m_is_scene_loaded || !m_are_buffers_initialized || has_dirty_arrays()) { 
+      Frame_profiler::Cpu_timer timer(m_profiler, Frame_profiler::LOAD_SCENE);
+      load_scene(); 
+    }
+    if(m_dynamic_geometry) { update_dynamic_geometry(); }
     
+    // Weighted blended transparency draws the frame in its own framebuffer, of the size of the viewport
+    m_oit_active = false;
+    if (use_oit() && m_draw_faces) {
+      GLint target = 0, samples = 0, viewport[4];
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+      glGetIntegerv(GL_SAMPLES, &samples);
+      glGetIntegerv(GL_VIEWPORT, viewport);
+      m_oit_active = m_oit_framebuffer.resize(viewport[0] + viewport[2], viewport[1] + viewport[3], samples);
+      if (m_oit_active) { m_oit_framebuffer.begin(target); }
+      else { glBindFramebuffer(GL_FRAMEBUFFER, target); }
+    }
+
     glClearColor(1.0f,1.0f,1.0f, 1.f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_PROGRAM_POINT_SIZE);
     glEnable(GL_LINE_SMOOTH);
     
-    update_uniforms();
+    {
+      Frame_profiler::Cpu_timer timer(m_profiler, Frame_profiler::UPDATE_UNIFORMS);
+      update_uniforms();
+    }
+
+    // Per draw parameters: written with the indirect commands, or constant (vertex colors, no point spacing)
+    if (use_multi_draw_indirect()) { 
+      begin_draw_commands(); 
+    } else if (m_is_opengl_4_3) { 
+      glVertexAttrib2f(DRAW_PARAMS_LOCATION, 1.f, 0.f); 
+    }
 
     bool half = m_use_clipping_plane == CLIPPING_PLANE_SOLID_HALF_ONLY;
     
     if (m_draw_vertices)  { 
+      m_profiler.begin_gpu(Frame_profiler::VERTICES);
       draw_vertices(half ? DRAW_INSIDE_ONLY : DRAW_ALL); 
+      m_profiler.end_gpu();
     }
     if (m_draw_edges) {
+      m_profiler.begin_gpu(Frame_profiler::EDGES);
       draw_edges(half ? DRAW_INSIDE_ONLY : DRAW_ALL); 
+      m_profiler.end_gpu();
     }
     if (m_draw_faces)     { draw_faces(); }
-    if (m_draw_rays)      { draw_rays(); } 
-    if (m_draw_lines)     { draw_lines(); }
+    if (m_draw_rays)      { 
+      m_profiler.begin_gpu(Frame_profiler::RAYS);
+      draw_rays(); 
+      m_profiler.end_gpu();
+    } 
+    if (m_draw_lines)     { 
+      m_profiler.begin_gpu(Frame_profiler::LINES);
+      draw_lines(); 
+      m_profiler.end_gpu();
+    }
+
+    disable_clip_distances();
+    if (m_oit_active) { m_oit_framebuffer.end(m_copy_shader); }
+    if (m_dynamic_geometry) { end_dynamic_frame(); }
   }
 
   Basic_Viewer::vec4f Basic_Viewer::color_to_vec4(const CGAL::IO::Color& c) const
@@ -367,12 +2012,35 @@ namespace CGAL::GLFW {
   {
     m_face_shader.use();
 
+    if (m_use_clipping_plane == CLIPPING_PLANE_SOLID_HALF_TRANSPARENT_HALF && m_oit_active) {
+      // 1. draw solid first
+      m_profiler.begin_gpu(Frame_profiler::FACES_INSIDE);
+      draw_faces_(DRAW_INSIDE_ONLY);
+      m_profiler.end_gpu();
+
+      // 2. accumulate the transparent layers in any order, without culling, and blend their average over the solid
+      m_profiler.begin_gpu(Frame_profiler::FACES_OUTSIDE);
+      m_oit_framebuffer.begin_transparency();
+      draw_faces_(DRAW_OUTSIDE_ONLY);
+      disable_clip_distances();
+      m_oit_framebuffer.composite(m_oit_composite_shader);
+      m_profiler.end_gpu();
+
+      // 3. render clipping plane here
+      m_profiler.begin_gpu(Frame_profiler::CLIPPING_PLANE);
+      render_clipping_plane();
+      m_profiler.end_gpu();
+      return;
+    }
+
     if (m_use_clipping_plane == CLIPPING_PLANE_SOLID_HALF_TRANSPARENT_HALF) {
       // The z-buffer will prevent transparent objects from being displayed behind other transparent objects.
       // Before rendering all transparent objects, disable z-testing first.
 
       // 1. draw solid first
+      m_profiler.begin_gpu(Frame_profiler::FACES_INSIDE);
       draw_faces_(DRAW_INSIDE_ONLY);
+      m_profiler.end_gpu();
 
       // 2. draw transparent layer second with back face culling to avoid messy triangles
       glDepthMask(false); //disable z-testing
@@ -381,16 +2049,22 @@ namespace CGAL::GLFW {
       glEnable(GL_CULL_FACE);
       glCullFace(GL_BACK);
       glFrontFace(GL_CW);
+      m_profiler.begin_gpu(Frame_profiler::FACES_OUTSIDE);
       draw_faces_(DRAW_OUTSIDE_ONLY);
+      m_profiler.end_gpu();
 
       // 3. draw solid again without culling and blend to make sure the solid mesh is visible
       glDepthMask(true); //enable z-testing
       glDisable(GL_CULL_FACE);
       glDisable(GL_BLEND);
+      m_profiler.begin_gpu(Frame_profiler::FACES_INSIDE_AGAIN);
       draw_faces_(DRAW_INSIDE_ONLY);
+      m_profiler.end_gpu();
 
       // 4. render clipping plane here
+      m_profiler.begin_gpu(Frame_profiler::CLIPPING_PLANE);
       render_clipping_plane();
+      m_profiler.end_gpu();
       return;
     }
       
@@ -398,124 +2072,389 @@ namespace CGAL::GLFW {
         m_use_clipping_plane == CLIPPING_PLANE_SOLID_HALF_ONLY) 
     {
       // 1. draw solid HALF
+      m_profiler.begin_gpu(Frame_profiler::FACES_INSIDE);
       draw_faces_(DRAW_INSIDE_ONLY);
+      m_profiler.end_gpu();
 
       // 2. render clipping plane here
+      m_profiler.begin_gpu(Frame_profiler::CLIPPING_PLANE);
       render_clipping_plane();
+      m_profiler.end_gpu();
       return;
     }
 
     // 1. draw solid FOR ALL
+    m_profiler.begin_gpu(Frame_profiler::FACES);
     draw_faces_(DRAW_ALL); 
+    m_profiler.end_gpu();
   }
 
   void Basic_Viewer::draw_faces_(RenderMode mode){
     m_face_shader.use();
-    m_face_shader.setFloat("rendering_mode", mode);
+    m_face_shader.setFloat(m_face_uniforms.rendering_mode, mode);
+    enable_clip_distances(mode);
+
+    if (use_lod()) {
+      draw_lod_faces();
+      return;
+    }
 
-    vec4f color = color_to_vec4(m_faces_mono_color);    
+    draw_category(VAO_MONO_FACES, GL_TRIANGLES, color_to_vec4(m_faces_mono_color));
 
-    glBindVertexArray(m_vao[VAO_MONO_FACES]);
-    glVertexAttrib4fv(2, color.data());
-    glDrawArrays(GL_TRIANGLES, 0, m_scene->number_of_elements(Graphics_scene::POS_MONO_FACES));
-  
-    glBindVertexArray(m_vao[VAO_COLORED_FACES]);
+    if (use_direct_mesh()) {
+      draw_direct_mesh();
+    }
+  }
+
+  // Mono VAO vao and colored VAO vao+1 of a category, color is the mono color.
+  // The shader of the category must be in use.
+  void Basic_Viewer::draw_category(int vao, GLenum mode, vec4f color) {
+    const int colorLocation = vao >= VAO_MONO_FACES ? 2 : 1;
+    const int gsEnum = Graphics_scene::BEGIN_POS + vao; // POS_* arrays are in the order of the VAOs
+
+    if (use_multi_draw_indirect()) {
+      Shader& shader = vao >= VAO_MONO_FACES ? m_face_shader : m_pl_shader;
+      shader.setVec4f((vao >= VAO_MONO_FACES ? m_face_uniforms : m_pl_uniforms).mono_color, color.data());
+
+      // Both parts in one submission, each command with its color source
+      glBindVertexArray(m_vao[vao]);
+      for (int part : {vao, vao + 1}) {
+        m_draw_ranges.clear();
+        collect_ranges(part, gsEnum + (part - vao));
+
+        const float colorSource = part == vao || m_use_mono_color ? 0.f : 1.f;
+        for (const Draw_range& range : m_draw_ranges) {
+          add_draw_command(part, range, colorSource);
+        }
+      }
+      submit_draw_commands(mode, is_indexed(vao) ? m_element_type[vao] : 0);
+      return;
+    }
+
+    glBindVertexArray(m_vao[vao]);
+    glVertexAttrib4fv(colorLocation, color.data());
+    draw_vao(vao, mode, gsEnum);
 
+    glBindVertexArray(m_vao[vao + 1]);
     if (m_use_mono_color) {
-      glDisableVertexAttribArray(2);
-      glVertexAttrib4fv(2, color.data());
+      glDisableVertexAttribArray(colorLocation);
+      glVertexAttrib4fv(colorLocation, color.data());
     } else {
+      glEnableVertexAttribArray(colorLocation);
+    }
+    draw_vao(vao + 1, mode, gsEnum + 1);
+  }
+
+  void Basic_Viewer::draw_vao(int vao, GLenum mode, int gsEnum) {
+    m_draw_ranges.clear();
+    collect_ranges(vao, gsEnum);
+
+    const bool indexed = is_indexed(vao);
+    const std::size_t indexSize = m_element_type[vao] == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+    // One multi draw per point spacing, the ranges of octree nodes are sorted by spacing
+    for (std::size_t i = 0; i < m_draw_ranges.size();) {
+      const float spacing = m_draw_ranges[i].spacing;
+
+      m_draw_firsts.clear();
+      m_draw_counts.clear();
+      m_draw_offsets.clear();
+      for (; i < m_draw_ranges.size() && m_draw_ranges[i].spacing == spacing; ++i) {
+        const Draw_range& range = m_draw_ranges[i];
+        m_draw_firsts.push_back(static_cast<GLint>(range.first));
+        m_draw_counts.push_back(static_cast<GLsizei>(range.count));
+        m_draw_offsets.push_back(reinterpret_cast<const void*>(range.first * indexSize));
+      }
+
+      const GLsizei drawCount = static_cast<GLsizei>(m_draw_counts.size());
+      if (spacing > 0.f) { glVertexAttrib2f(DRAW_PARAMS_LOCATION, 1.f, spacing); }
+
+      if (indexed) {
+        glMultiDrawElements(mode, m_draw_counts.data(), m_element_type[vao], m_draw_offsets.data(), drawCount);
+      } else {
+        glMultiDrawArrays(mode, m_draw_firsts.data(), m_draw_counts.data(), drawCount);
+      }
+
+      if (spacing > 0.f) { glVertexAttrib2f(DRAW_PARAMS_LOCATION, 1.f, 0.f); }
+    }
+  }
+
+  // Appends a range to m_draw_ranges, merged with the last one when they are consecutive in the buffer
+  void Basic_Viewer::add_draw_range(std::size_t first, std::size_t count, float spacing) {
+    if (!m_draw_ranges.empty()) {
+      Draw_range& last = m_draw_ranges.back();
+      if (last.first + last.count == first && last.spacing == spacing) {
+        last.count += count;
+        return;
+      }
+    }
+    m_draw_ranges.push_back({first, count, spacing});
+  }
+
+  // Visible ranges of a VAO: selected octree nodes, visible chunks or the whole VAO
+  void Basic_Viewer::collect_ranges(int vao, int gsEnum) {
+    if (vao <= VAO_COLORED_POINTS && !m_point_octrees[vao].empty()) {
+      collect_point_octree(vao);
+      return;
+    }
+
+    const std::vector<Chunk>& chunks = m_chunks[vao].chunks();
+    if (!use_chunks() || chunks.empty()) {
+      const std::size_t count = is_indexed(vao) ? static_cast<std::size_t>(m_element_count[vao])
+                                                : m_scene->number_of_elements(gsEnum);
+      if (count > 0) { add_draw_range(0, count, 0.f); }
+      return;
+    }
+
+    for (const Chunk& chunk : chunks) {
+      if (is_box_visible(chunk.box)) { add_draw_range(chunk.first, chunk.count, 0.f); }
+    }
+  }
+
+  void Basic_Viewer::collect_point_octree(int vao) {
+    const std::vector<Point_octree_node>& nodes = m_point_octrees[vao].nodes();
+    auto visible = [this, &nodes](std::int32_t n) { return !m_frustum_culling || is_box_visible(nodes[n].box); };
+
+    // Largest nodes on screen first (a node is always selected before its children) until the point budget is spent
+    auto& selected = m_octree_selected;
+    selected.assign(nodes.size(), 0);
+    std::priority_queue<std::pair<float, std::int32_t>> queue;
+    if (visible(0)) { queue.push({0.f, 0}); }
+
+    std::size_t budget = m_point_budget;
+    while (!queue.empty()) {
+      const std::int32_t n = queue.top().second;
+      const Point_octree_node& node = nodes[n];
+      queue.pop();
+
+      if (node.count > budget) break;
+      budget -= node.count;
+      selected[n] = 1;
+
+      // The children only add points closer than one pixel
+      if (node.spacing * projection_scale(node.box) < 1.f) continue;
+
+      for (std::int32_t child : node.children) {
+        if (child < 0 || !visible(child)) continue;
+        const Eigen::AlignedBox3f& box = nodes[child].box;
+        queue.push({box.diagonal().norm() * projection_scale(box), child});
+      }
+    }
+
+    // Nodes with visible children not drawn have their points enlarged to their spacing to fill the gaps
+    auto& draws = m_octree_draws;
+    draws.clear();
+    for (std::size_t n = 0; n < nodes.size(); ++n) {
+      if (!selected[n]) continue;
+
+      bool frontier = false;
+      for (std::int32_t child : nodes[n].children) {
+        frontier = frontier || (child >= 0 && !selected[child] && visible(child));
+      }
+      draws.push_back({frontier ? nodes[n].spacing : 0.f, static_cast<std::int32_t>(n)});
+    }
+
+    // Sorted by point spacing (one multi draw per spacing), nodes are in depth first order
+    std::sort(draws.begin(), draws.end());
+    for (const std::pair<float, std::int32_t>& draw : draws) {
+      const Point_octree_node& node = nodes[draw.second];
+      add_draw_range(node.first, node.count, draw.first);
+    }
+  }
+
+  void Basic_Viewer::draw_lod_faces() {
+    vec4f color = color_to_vec4(m_faces_mono_color);
+
+    glBindVertexArray(m_vao[VAO_LOD_FACES]);
+    if (use_multi_draw_indirect()) {
+      m_face_shader.setVec4f(m_face_uniforms.mono_color, color.data());
+      draw_lod_chunks(m_lod->mono_chunks(), 0.f);
+      draw_lod_chunks(m_lod->colored_chunks(), m_use_mono_color ? 0.f : 1.f);
+      submit_draw_commands(GL_TRIANGLES, GL_UNSIGNED_INT);
+      return;
+    }
+
+    glDisableVertexAttribArray(2);
+    glVertexAttrib4fv(2, color.data());
+    draw_lod_chunks(m_lod->mono_chunks(), 0.f);
+
+    if (!m_use_mono_color) {
       glEnableVertexAttribArray(2);
     }
+    draw_lod_chunks(m_lod->colored_chunks(), 1.f);
+  }
+
+  // Mono triangles first, then the colored ones (their color attribute disabled with the mono color)
+  void Basic_Viewer::draw_direct_mesh() {
+    vec4f color = color_to_vec4(m_faces_mono_color);
+    const std::size_t nbMono = m_direct_mesh->nb_mono_triangles;
+    const std::size_t nbColored = m_direct_mesh->nb_triangles - nbMono;
+
+    glBindVertexArray(m_vao[VAO_DIRECT_FACES]);
+    if (m_is_opengl_4_3) {
+      glVertexAttrib2f(DRAW_PARAMS_LOCATION, 1.f, 0.f); // vertex colors, also with multi draw indirect
+    }
+
+    glDisableVertexAttribArray(2);
+    glVertexAttrib4fv(2, color.data());
+    if (nbMono > 0) {
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * nbMono), GL_UNSIGNED_INT, nullptr);
+    }
 
-    glDrawArrays(GL_TRIANGLES, 0, m_scene->number_of_elements(Graphics_scene::POS_COLORED_FACES));
+    if (nbColored == 0) return;
+    if (!m_use_mono_color) {
+      glEnableVertexAttribArray(2);
+    }
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * nbColored), GL_UNSIGNED_INT,
+                   reinterpret_cast<const void*>(3 * nbMono * sizeof(std::uint32_t)));
   }
 
-  void Basic_Viewer::draw_rays() {
-    m_pl_shader.use();
-    m_pl_shader.setFloat("rendering_mode", RenderMode::DRAW_ALL);
-    
-    vec4f color = color_to_vec4(m_rays_mono_color);    
+  // Each visible chunk is drawn at its coarsest level whose projected error is below m_lod_pixel_error.
+  // With multi draw indirect, the levels are added to the commands of the next submission.
+  void Basic_Viewer::draw_lod_chunks(const std::vector<Lod_chunk>& chunks, float colorSource) {
+    const bool indirect = use_multi_draw_indirect();
+    m_draw_counts.clear();
+    m_draw_offsets.clear();
+    m_draw_base_vertices.clear();
+
+    for (const Lod_chunk& chunk : chunks) {
+      if (m_frustum_culling && !is_box_visible(chunk.box)) continue;
+
+      const float scale = projection_scale(chunk.box);
+      std::size_t l = chunk.levels.size() - 1;
+      while (l > 0 && chunk.levels[l].error * scale > m_lod_pixel_error) { --l; }
+
+      const Lod_level& level = chunk.levels[l];
+      if (indirect) {
+        m_draw_elements_commands.push_back({static_cast<GLuint>(level.nb_indices), 1, static_cast<GLuint>(level.first_index),
+                                            static_cast<GLint>(level.base_vertex), add_draw_params(colorSource, 0.f)});
+        continue;
+      }
 
-    glBindVertexArray(m_vao[VAO_MONO_RAYS]);
-    glVertexAttrib4fv(1, color.data());
+      m_draw_counts.push_back(static_cast<GLsizei>(level.nb_indices));
+      m_draw_offsets.push_back(reinterpret_cast<const void*>(level.first_index * sizeof(std::uint32_t)));
+      m_draw_base_vertices.push_back(static_cast<GLint>(level.base_vertex));
+    }
 
-    glLineWidth(m_size_rays);
-    glDrawArrays(GL_LINES, 0, m_scene->number_of_elements(Graphics_scene::POS_MONO_RAYS));
-  
-    glBindVertexArray(m_vao[VAO_COLORED_RAYS]);
-    if (m_use_mono_color) {
-      glDisableVertexAttribArray(1);
-      glVertexAttrib4fv(1, color.data());
-    } else {
-      glEnableVertexAttribArray(1);
+    if (m_draw_counts.empty()) return;
+
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_draw_counts.data(), GL_UNSIGNED_INT, m_draw_offsets.data(),
+                                  static_cast<GLsizei>(m_draw_counts.size()), m_draw_base_vertices.data());
+  }
+
+  // The command and parameter buffers are orphaned once per frame: the draws of the previous frame keep their storage
+  void Basic_Viewer::begin_draw_commands() {
+    m_draw_command_cursor = 0;
+    m_draw_params_cursor = 0;
+
+    if (m_draw_command_capacity > 0) {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_draw_command_buffer);
+      glBufferData(GL_DRAW_INDIRECT_BUFFER, m_draw_command_capacity, nullptr, GL_STREAM_DRAW);
+    }
+    if (m_draw_params_capacity > 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, m_draw_params_buffer);
+      glBufferData(GL_ARRAY_BUFFER, m_draw_params_capacity, nullptr, GL_STREAM_DRAW);
     }
-    glDrawArrays(GL_LINES, 0, m_scene->number_of_elements(Graphics_scene::POS_COLORED_RAYS));
   }
 
-  void Basic_Viewer::draw_vertices(RenderMode render) {
-    m_pl_shader.use();
-    m_pl_shader.setFloat("rendering_mode", render);
-    
-    vec4f color = color_to_vec4(m_vertices_mono_color);    
+  // Parameters of the next command, returns its base instance
+  GLuint Basic_Viewer::add_draw_params(float colorSource, float spacing) {
+    const GLuint instance = static_cast<GLuint>(m_draw_params_cursor + m_draw_params.size() / 2);
+    m_draw_params.push_back(colorSource);
+    m_draw_params.push_back(spacing);
+    return instance;
+  }
 
-    glBindVertexArray(m_vao[VAO_MONO_POINTS]);
-    glVertexAttrib4fv(1, color.data());
-    glDrawArrays(GL_POINTS, 0, m_scene->number_of_elements(Graphics_scene::POS_MONO_POINTS));
-  
-    glBindVertexArray(m_vao[VAO_COLORED_POINTS]);
-    if (m_use_mono_color) {
-      glDisableVertexAttribArray(1);
-      glVertexAttrib4fv(1, color.data());
+  // Command of a range of the VAO vao, relative to the buffers of its category
+  void Basic_Viewer::add_draw_command(int vao, const Draw_range& range, float colorSource) {
+    const GLuint count = static_cast<GLuint>(range.count);
+    const GLuint instance = add_draw_params(colorSource, range.spacing);
+
+    if (is_indexed(vao)) {
+      m_draw_elements_commands.push_back({count, 1, static_cast<GLuint>(m_first_index[vao] + range.first),
+                                          static_cast<GLint>(m_merged_first[vao]), instance});
     } else {
-      glEnableVertexAttribArray(1);
+      m_draw_arrays_commands.push_back({count, 1, static_cast<GLuint>(m_merged_first[vao] + range.first), instance});
+    }
+  }
+
+  // One glMultiDraw*Indirect call for the commands added since the last submission,
+  // indexType is 0 for array commands
+  void Basic_Viewer::submit_draw_commands(GLenum mode, GLenum indexType) {
+    const std::size_t nbDraws = m_draw_params.size() / 2;
+
+    if (nbDraws > 0) {
+      const std::size_t paramsSize = 2 * sizeof(float);
+      stream_buffer(GL_ARRAY_BUFFER, m_draw_params_buffer, m_draw_params_capacity,
+                    m_draw_params_cursor * paramsSize, nbDraws * paramsSize, m_draw_params.data());
+
+      const std::size_t commandSize = indexType != 0 ? sizeof(Draw_elements_command) : sizeof(Draw_arrays_command);
+      const void* commands = indexType != 0 ? static_cast<const void*>(m_draw_elements_commands.data())
+                                            : static_cast<const void*>(m_draw_arrays_commands.data());
+      stream_buffer(GL_DRAW_INDIRECT_BUFFER, m_draw_command_buffer, m_draw_command_capacity,
+                    m_draw_command_cursor, nbDraws * commandSize, commands);
+
+      const void* offset = reinterpret_cast<const void*>(m_draw_command_cursor);
+      if (indexType != 0) {
+        glMultiDrawElementsIndirect(mode, indexType, offset, static_cast<GLsizei>(nbDraws), 0);
+      } else {
+        glMultiDrawArraysIndirect(mode, offset, static_cast<GLsizei>(nbDraws), 0);
+      }
+
+      m_draw_params_cursor += nbDraws;
+      m_draw_command_cursor += nbDraws * commandSize;
     }
-    glDrawArrays(GL_POINTS, 0, m_scene->number_of_elements(Graphics_scene::POS_COLORED_POINTS));
 
+    m_draw_params.clear();
+    m_draw_arrays_commands.clear();
+    m_draw_elements_commands.clear();
+  }
+
+  // Writes size bytes at offset in a buffer filled during the frame, its storage grows when needed
+  void Basic_Viewer::stream_buffer(GLenum target, GLuint buffer, std::size_t& capacity,
+                                   std::size_t offset, std::size_t size, const void* data) {
+    glBindBuffer(target, buffer);
+    if (offset + size > capacity) {
+      // The draws already submitted keep the old storage, the new one only holds the next ones
+      capacity = 2 * (offset + size);
+      glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(target, offset, size, data);
+  }
+
+  void Basic_Viewer::draw_rays() {
+    m_pl_shader.use();
+    m_pl_shader.setFloat(m_pl_uniforms.rendering_mode, RenderMode::DRAW_ALL);
+    enable_clip_distances(DRAW_ALL);
+
+    glLineWidth(m_size_rays);
+    draw_category(VAO_MONO_RAYS, GL_LINES, color_to_vec4(m_rays_mono_color));
+  }
+
+  void Basic_Viewer::draw_vertices(RenderMode render) {
+    m_pl_shader.use();
+    m_pl_shader.setFloat(m_pl_uniforms.rendering_mode, render);
+    enable_clip_distances(render);
+
+    draw_category(VAO_MONO_POINTS, GL_POINTS, color_to_vec4(m_vertices_mono_color));
   }
 
   void Basic_Viewer::draw_lines() {
     m_pl_shader.use();
-    m_pl_shader.setFloat("rendering_mode", RenderMode::DRAW_ALL);
-    
-    vec4f color = color_to_vec4(m_lines_mono_color);    
-    
-    glBindVertexArray(m_vao[VAO_MONO_LINES]);
-    glVertexAttrib4fv(1, color.data());
+    m_pl_shader.setFloat(m_pl_uniforms.rendering_mode, RenderMode::DRAW_ALL);
+    enable_clip_distances(DRAW_ALL);
+
     glLineWidth(m_size_lines);
-    glDrawArrays(GL_LINES, 0, m_scene->number_of_elements(Graphics_scene::POS_MONO_LINES));
-  
-  
-    glBindVertexArray(m_vao[VAO_COLORED_LINES]);
-    if (m_use_mono_color) {
-      glDisableVertexAttribArray(1);
-      glVertexAttrib4fv(1, color.data());
-    } else {
-      glEnableVertexAttribArray(1);
-    }
-    glDrawArrays(GL_LINES, 0, m_scene->number_of_elements(Graphics_scene::POS_COLORED_LINES));
+    draw_category(VAO_MONO_LINES, GL_LINES, color_to_vec4(m_lines_mono_color));
   }
 
   void Basic_Viewer::draw_edges(RenderMode mode) {
     m_pl_shader.use();
-    m_pl_shader.setFloat("rendering_mode", mode);
-          
-    vec4f color = color_to_vec4(m_edges_mono_color);    
+    m_pl_shader.setFloat(m_pl_uniforms.rendering_mode, mode);
+    enable_clip_distances(mode);
 
-    glBindVertexArray(m_vao[VAO_MONO_SEGMENTS]);
-    glVertexAttrib4fv(1, color.data());
     glLineWidth(m_size_edges);
-    glDrawArrays(GL_LINES, 0, m_scene->number_of_elements(Graphics_scene::POS_MONO_SEGMENTS));
-  
-    glBindVertexArray(m_vao[VAO_COLORED_SEGMENTS]);
-    if (m_use_mono_color) {
-      glDisableVertexAttribArray(1);
-      glVertexAttrib4fv(1, color.data());
-    } else {
-      glEnableVertexAttribArray(1);
-    }
-    glDrawArrays(GL_LINES, 0, m_scene->number_of_elements(Graphics_scene::POS_COLORED_SEGMENTS));
-    
+    draw_category(VAO_MONO_SEGMENTS, GL_LINES, color_to_vec4(m_edges_mono_color));
   }
 
   void Basic_Viewer::generate_clipping_plane() {
@@ -550,6 +2489,7 @@ namespace CGAL::GLFW {
 
   void Basic_Viewer::render_clipping_plane() {
     if (!m_clipping_plane_rendering || !m_is_opengl_4_3) return;
+    disable_clip_distances();
     m_plane_shader.use();
     glBindVertexArray(m_vao[VAO_CLIPPING_PLANE]);
     glLineWidth(0.1f);
@@ -568,6 +2508,10 @@ namespace CGAL::GLFW {
   {
     Basic_Viewer* viewer = static_cast<Basic_Viewer*>(glfwGetWindowUserPointer(window)); 
     viewer->on_cursor_event(xpos, ypo);
+
+    if (viewer->m_pick_callback) {
+      viewer->m_pick_callback(viewer->pick(viewer->get_cursor(), viewer->m_pick_radius, false));
+    }
   }
 
   
@@ -584,6 +2528,13 @@ namespace CGAL::GLFW {
     viewer->set_cam_mode(viewer->m_cam_mode);
 
     glViewport(0, 0, width, height);
+    viewer->m_redraw = true;
+  }
+
+  // The window content was damaged (uncovered, restored...)
+  void Basic_Viewer::window_refresh_callback(GLFWwindow* window) {
+    Basic_Viewer* viewer = static_cast<Basic_Viewer*>(glfwGetWindowUserPointer(window)); 
+    viewer->m_redraw = true;
   }
 
   void Basic_Viewer::scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
@@ -604,10 +2555,18 @@ namespace CGAL::GLFW {
   }
 
   void Basic_Viewer::action_event(ActionEnum action){
+    // Actions move the camera or the clipping plane or change a setting
+    m_redraw = true;
+
     if (action == EXIT) {
       m_pl_shader.destroy();
       m_face_shader.destroy(); 
       m_plane_shader.destroy();
+      m_oit_composite_shader.destroy();
+      m_copy_shader.destroy();
+      m_oit_framebuffer.destroy();
+      finish_captures();
+      m_profiler.release_gpu_timers();
       glfwDestroyWindow(m_window);
       glfwTerminate();
       exit(EXIT_SUCCESS);
@@ -651,6 +2610,14 @@ namespace CGAL::GLFW {
         screenshot("./screenshot.png");
         std::cout << "Screenshot saved in local directory." << std::endl; 
         break;
+      case RECORD:
+        if (m_recording) {
+          stop_recording();
+        } else {
+          start_recording(RECORD_PATH);
+          std::cout << "Recording to " << RECORD_PATH << std::endl;
+        }
+        break;
       case INC_ZOOM:
         zoom(1.0f);
         break;
@@ -701,12 +2668,16 @@ namespace CGAL::GLFW {
         break;
       case SHADING_MODE:
         m_flat_shading = !m_flat_shading;
-        m_are_buffers_initialized = false;
+        if (!use_gpu_normals()) {
+          update_normal_arrays();
+        }
         break;
       case INVERSE_NORMAL:
         m_inverse_normal = !m_inverse_normal;
-        m_scene->reverse_all_normals();
-        m_are_buffers_initialized = false;
+        if (!use_gpu_normals()) {
+          m_scene->reverse_all_normals();
+          update_normal_arrays();
+        }
         break;
       case MONO_COLOR:
         m_use_mono_color = !m_use_mono_color;
@@ -811,6 +2782,7 @@ namespace CGAL::GLFW {
 
     add_action(GLFW_KEY_ENTER, GLFW_KEY_LEFT_ALT, false, FULLSCREEN);
     add_action(GLFW_KEY_F1, false, SCREENSHOT);
+    add_action(GLFW_KEY_F2, false, RECORD);
 
     add_action(GLFW_KEY_X, false, INC_MOVE_SPEED_1);
     add_action(GLFW_KEY_X, GLFW_KEY_LEFT_CONTROL, false, INC_MOVE_SPEED_D1);
@@ -873,6 +2845,7 @@ namespace CGAL::GLFW {
 
       {FULLSCREEN, "Switch to windowed/fullscreen mode"},
       {SCREENSHOT, "Take a screenshot of the current view"},
+      {RECORD, "Start/stop recording the frames (see RECORD_PATH)"},
       
       {MOUSE_ROTATE, "Rotate the view"},
       {MOUSE_TRANSLATE, "Move the view"},
@@ -1171,24 +3144,27 @@ namespace CGAL::GLFW {
     set_cam_mode(PERSPECTIVE);
   }
 
-  void Basic_Viewer::screenshot(const std::string& filepath) {
+  void Basic_Viewer::screenshot(const std::string& filepath, Captured_frame* image) {
     // https://lencerf.y()ithub.io/post/2019-09-21-save-the-opengl-rendering-to-image-file/ (thanks)
     // https://github.com/nothings/stb/
     // The stb lib used here is from glfw/deps 
     
-    const GLsizei nrChannels = 3;
-    GLsizei stride = nrChannels * m_window_size.x();
-    stride += (stride % 4) ? (4 - stride % 4) : 0; // stride must be a multiple of 4
-    GLsizei bufferSize = stride * m_window_size.y();
-
-    std::vector<char> buffer(bufferSize);
-
-    glPixelStorei(GL_PACK_ALIGNMENT, 4);
-    glReadBuffer(GL_FRONT);
-    glReadPixels(0, 0, m_window_size.x(), m_window_size.y(), GL_RGB, GL_UNSIGNED_BYTE, buffer.data());
+    // The frame is drawn again in a multisampled framebuffer object: the window content
+    // (hidden, covered or being swapped) is never read back
+    if (!m_offscreen_framebuffer.resize(m_window_size.x(), m_window_size.y(), OFFSCREEN_SAMPLES)) {
+      std::cerr << "Offscreen framebuffer incomplete, no screenshot" << std::endl;
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      return;
+    }
+    m_offscreen_framebuffer.bind();
+    glViewport(0, 0, m_window_size.x(), m_window_size.y());
+    render_scene();
+    m_offscreen_framebuffer.resolve();
 
-    stbi_flip_vertically_on_write(true);
-    stbi_write_png(filepath.data(), m_window_size.x(), m_window_size.y(), nrChannels, buffer.data(), stride);
+    // Read back asynchronously, the image is encoded and written by m_frame_writer or copied to image
+    m_readback.init(CAPTURE_PBO_COUNT);
+    m_readback.read(m_window_size.x(), m_window_size.y(), filepath, m_frame_writer, image);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
   // Blocking call
@@ -1201,4 +3177,20 @@ namespace CGAL::GLFW {
   {
     Basic_Viewer(graphics_scene, title).show();
   }
+
+  inline void draw_graphics_scene(const Graphics_scene &graphics_scene, const Lod_mesh &lod, const char *title)
+  {
+    Basic_Viewer viewer(&graphics_scene, title);
+    viewer.lod_mesh(&lod);
+    viewer.show();
+  }
+
+  inline void draw_graphics_scene(const Graphics_scene &graphics_scene, const Lod_mesh &lod, 
+                                  const Direct_mesh &direct, const char *title)
+  {
+    Basic_Viewer viewer(&graphics_scene, title);
+    viewer.lod_mesh(&lod);
+    viewer.direct_mesh(&direct);
+    viewer.show();
+  }
 } 
@@ -14,11 +14,224 @@
 #define WINDOW_SAMPLES 4
 #endif
 
+// true: buffer swaps wait for the vertical refresh of the screen
+#ifndef VSYNC
+#define VSYNC true
+#endif
+
+// maximal number of frames per second while animating, 0 for no limit
+#ifndef MAX_FRAME_RATE
+#define MAX_FRAME_RATE 0
+#endif
+
+// frames are only drawn when something changed: when idle, the event loop sleeps until an event
+// or at most this long (in seconds) before checking the scene arrays again
+#ifndef IDLE_WAIT_TIMEOUT
+#define IDLE_WAIT_TIMEOUT 0.25
+#endif
+
+/*************OFFSCREEN PARAMS*************/
+
+// context of make_screenshot:
+//   OFFSCREEN_GLFW    hidden GLFW window, needs a display server
+//   OFFSCREEN_OSMESA  OSMesa context created by GLFW (software rendering, libOSMesa is loaded at run time),
+//                     no display server is needed when GLFW is built with GLFW_USE_OSMESA
+//   OFFSCREEN_EGL     EGL surfaceless context (no display server, llvmpipe without GPU), links with libEGL
+#define OFFSCREEN_GLFW 0
+#define OFFSCREEN_OSMESA 1
+#define OFFSCREEN_EGL 2
+
+#ifndef OFFSCREEN_CONTEXT
+#define OFFSCREEN_CONTEXT OFFSCREEN_GLFW
+#endif
+
+// samples of the multisampled offscreen framebuffer (screenshots)
+#ifndef OFFSCREEN_SAMPLES
+#define OFFSCREEN_SAMPLES WINDOW_SAMPLES
+#endif
+
+/*************CAPTURE PARAMS*************/
+
+// pixel pack buffers of the asynchronous readback ring (screenshots and recording)
+#ifndef CAPTURE_PBO_COUNT
+#define CAPTURE_PBO_COUNT 3
+#endif
+
+// threads encoding and writing the captured frames
+#ifndef CAPTURE_THREADS
+#define CAPTURE_THREADS 2
+#endif
+
+// maximal number of captured frames waiting for a thread, the render loop waits beyond that
+#ifndef CAPTURE_QUEUE_SIZE
+#define CAPTURE_QUEUE_SIZE 8
+#endif
+
+// 0 (stored, fastest) to 9 (smallest files)
+#ifndef PNG_COMPRESSION_LEVEL
+#define PNG_COMPRESSION_LEVEL 6
+#endif
+
+// threads compressing the strips of rows of one PNG image, 0 for one per core
+#ifndef PNG_THREADS
+#define PNG_THREADS 0
+#endif
+
+// maximal size in pixels of the tiles of make_poster (rendered samples, margins included)
+#ifndef POSTER_TILE_SIZE
+#define POSTER_TILE_SIZE 2048
+#endif
+
+// pixels rendered around each tile of make_poster and cropped, so that points and lines
+// crossing the border of a tile are not cut
+#ifndef POSTER_TILE_MARGIN
+#define POSTER_TILE_MARGIN 16
+#endif
+
+// file of the recording started with the record key, a .y4m stream or an image sequence pattern
+#ifndef RECORD_PATH
+#define RECORD_PATH "./record_%05d.png"
+#endif
+
+// frames per second of the recordings, 0 to record every drawn frame
+#ifndef RECORD_FRAME_RATE
+#define RECORD_FRAME_RATE 0
+#endif
+
+/*************VERTEX BUFFERS PARAMS*************/
+
+// true: position/normal/color packed per vertex in one buffer for each VAO
+// false: one buffer per attribute
+#ifndef INTERLEAVED_VERTEX_LAYOUT
+#define INTERLEAVED_VERTEX_LAYOUT true
+#endif
+
+// true: faces are welded and drawn with glDrawElements (16-bit indices when possible)
+#ifndef INDEXED_FACES
+#define INDEXED_FACES true
+#endif
+
+// true: 16-bit positions in the scene bounding box, octahedron encoded 16-bit normals and 8-bit colors
+// (16 bytes per face vertex instead of 36)
+#ifndef COMPACT_VERTICES
+#define COMPACT_VERTICES false
+#endif
+
+// number of frames in flight for the dynamic geometry position rings
+#ifndef DYNAMIC_RING_SIZE
+#define DYNAMIC_RING_SIZE 3
+#endif
+
+// maximum wait for a segment of the rings still read by the GPU, in nanoseconds
+#ifndef DYNAMIC_WAIT_TIMEOUT
+#define DYNAMIC_WAIT_TIMEOUT 1000000000ull
+#endif
+
+// true: the primitives of each VAO are sorted into spatial chunks, only the chunks
+// intersecting the view frustum are drawn
+#ifndef FRUSTUM_CULLING
+#define FRUSTUM_CULLING true
+#endif
+
+// maximal number of primitives (points, segments or triangles) per chunk
+#ifndef CHUNK_SIZE
+#define CHUNK_SIZE 4096
+#endif
+
+// true: mono and colored elements of a category share one buffer, each category is drawn with a
+// single glMultiDraw*Indirect call (OpenGL 4.3, interleaved layout only)
+#ifndef MULTI_DRAW_INDIRECT
+#define MULTI_DRAW_INDIRECT true
+#endif
+
+/*************LEVEL OF DETAIL PARAMS*************/
+
+// maximal number of triangles per chunk of a Lod_mesh
+#ifndef LOD_CHUNK_SIZE
+#define LOD_CHUNK_SIZE 16384
+#endif
+
+// maximal number of levels per chunk (the full resolution included)
+#ifndef LOD_LEVELS
+#define LOD_LEVELS 6
+#endif
+
+// ratio of triangles kept from one level to the next
+#ifndef LOD_REDUCTION
+#define LOD_REDUCTION 0.25f
+#endif
+
+// maximal distance between a level and the full resolution chunk, as a fraction of the chunk diagonal
+#ifndef LOD_MAX_ERROR
+#define LOD_MAX_ERROR 0.02f
+#endif
+
+// maximal projected error, in pixels, of the selected levels
+#ifndef LOD_PIXEL_ERROR
+#define LOD_PIXEL_ERROR 1.0f
+#endif
+
+// surface meshes with at least this number of faces are drawn with levels of detail (their faces are only added
+// to the scene if the levels of detail cannot be drawn)
+#ifndef LOD_MIN_FACES
+#define LOD_MIN_FACES 1000000
+#endif
+
+// surface meshes with at least this number of faces (and less than LOD_MIN_FACES) write their faces straight
+// into the GPU buffers
+#ifndef DIRECT_MESH_MIN_FACES
+#define DIRECT_MESH_MIN_FACES 500000
+#endif
+
+/*************STREAM PARAMS*************/
+
+// bytes of a file parsed between two chunks sent to the viewer by the streamed drawings
+#ifndef STREAM_CHUNK_BYTES
+#define STREAM_CHUNK_BYTES (8 << 20)
+#endif
+
+/*************POINT CLOUD PARAMS*************/
+
+// true: large point arrays are drawn progressively from a nested octree
+#ifndef POINT_OCTREE
+#define POINT_OCTREE true
+#endif
+
+// point arrays with at least this number of points are drawn from an octree
+#ifndef POINT_OCTREE_MIN_POINTS
+#define POINT_OCTREE_MIN_POINTS 1000000
+#endif
+
+// maximal number of points drawn per frame from the octrees
+#ifndef POINT_BUDGET
+#define POINT_BUDGET 3000000
+#endif
+
+// subsampling grid resolution of an octree node (at most one point per cell)
+#ifndef POINT_OCTREE_GRID
+#define POINT_OCTREE_GRID 128
+#endif
+
+// nodes with at most this number of points are not subdivided
+#ifndef POINT_OCTREE_LEAF_SIZE
+#define POINT_OCTREE_LEAF_SIZE 16384
+#endif
+
+#ifndef POINT_OCTREE_MAX_DEPTH
+#define POINT_OCTREE_MAX_DEPTH 20
+#endif
+
 /*********************************************/
 #ifndef CLIPPING_PLANE_RENDERING_TRANSPARENCY
 #define CLIPPING_PLANE_RENDERING_TRANSPARENCY 0.5f
 #endif
 
+// Transparent half of the clipping plane drawn with weighted blended order independent
+// transparency (OpenGL 4.3), instead of unsorted alpha blending with back face culling
+#ifndef WEIGHTED_BLENDED_OIT
+#define WEIGHTED_BLENDED_OIT true
+#endif
+
 
 #ifndef SIZE_POINTS
 #define SIZE_POINTS 7.0f
@@ -98,4 +311,56 @@
 
 #ifndef SCENE_ROT_SPEED
 #define SCENE_ROT_SPEED 0.5f
-#endif
\ No newline at end of file
+#endif
+
+/*************PICKING PARAMS*************/
+
+// true: the BVHs of the points, segments and faces are built when the scene is loaded, otherwise at the first pick
+#ifndef PICKING
+#define PICKING false
+#endif
+
+// tolerance in pixels around the cursor to pick a vertex or an edge
+#ifndef PICK_RADIUS
+#define PICK_RADIUS 5.f
+#endif
+
+// maximal number of primitives of a BVH leaf
+#ifndef BVH_LEAF_SIZE
+#define BVH_LEAF_SIZE 4
+#endif
+
+// BVH subtrees of at least this number of primitives are built by another thread
+#ifndef BVH_PARALLEL_SIZE
+#define BVH_PARALLEL_SIZE 65536
+#endif
+
+/*************SHADER PARAMS*************/
+
+// program binary cache, shared by the contexts and the runs using the same driver
+#ifndef SHADER_CACHE
+#define SHADER_CACHE true
+#endif
+
+// directory of the program binaries, empty for a directory in the cache directory of the user
+// (no cache when it is unknown)
+#ifndef SHADER_CACHE_DIRECTORY
+#define SHADER_CACHE_DIRECTORY ""
+#endif
+
+/*************PROFILING PARAMS*************/
+
+// true: GPU passes and some CPU sections are timed (see Frame_profiler)
+#ifndef PROFILING
+#define PROFILING false
+#endif
+
+// number of samples of the rolling statistics of each pass
+#ifndef PROFILING_WINDOW
+#define PROFILING_WINDOW 120
+#endif
+
+// period in seconds of the statistics dump to stdout, 0 for none
+#ifndef PROFILING_REPORT_PERIOD
+#define PROFILING_REPORT_PERIOD 0
+#endif
@@ -0,0 +1,270 @@
+#pragma once
+
+/*
+ * GLSL sources of the OpenGL 4.3 programs. The "#version" line, the optional "#define" lines
+ * selecting a variant then the Frame_uniforms block are prepended by Basic_Viewer::compile_shaders().
+ *
+ * Variants:
+ *   COMPACT_VERTICES    positions are 16-bit unorm in the scene bounding box (bbox_min, bbox_extent),
+ *                       normals are octahedron encoded in 2x16-bit snorm, colors are 8-bit unorm
+ *   MAX_CLIP_DISTANCES  always defined, GL_MAX_CLIP_DISTANCES of the context
+ *
+ * Clipping is done by the hardware: clip_planes are model space planes, the first nb_clip_distances
+ * are written to gl_ClipDistance. The first one is the clipping plane, its sign given by rendering_mode
+ * (-1 draw all, 0 inside only, 1 outside only), the viewer only enables it when drawing a half.
+ *
+ * The per frame state (camera, light, clipping) is in the Frame_uniforms block, shared by the face,
+ * point and line, and clipping plane programs. Only rendering_mode and mono_color are set per draw.
+ *
+ * draw_params holds per draw values (instanced attribute indexed by the base instance of the
+ * indirect commands, or a constant attribute): x is the color source (1 for the vertex color,
+ * 0 for mono_color), y the spacing of octree points.
+ */
+
+namespace CGAL::GLFW {
+
+/*************FRAME UNIFORMS*************/
+
+// std140, mirrored by Basic_Viewer::Frame_uniforms
+const char uniform_block_frame[]=R"DELIM(
+layout(std140, binding = 0) uniform Frame_uniforms {
+  highp mat4 mvp_matrix;
+  highp mat4 mv_matrix;
+  highp mat4 clipping_matrix;         // model matrix of the clipping plane
+  highp vec4 light_pos;
+  highp vec4 light_diff;
+  highp vec4 light_spec;
+  highp vec4 light_amb;
+  highp vec3 bbox_min;
+  highp float spec_power;
+  highp vec3 bbox_extent;
+  highp float flat_shading;
+  highp float normal_sign;            // -1 to inverse normals
+  highp float point_size;
+  highp float pixels_per_unit;        // screen size of one unit at distance 1
+  highp float rendering_transparency;
+  int nb_clip_distances;
+  highp vec4 clip_planes[MAX_CLIP_DISTANCES];
+};
+)DELIM";
+
+/*************FACES*************/
+
+const char vertex_source_face[]=R"DELIM(
+layout(location = 0) in highp vec4 vertex;
+#ifdef COMPACT_VERTICES
+layout(location = 1) in highp vec2 normal;
+layout(location = 2) in mediump vec4 color;
+#else
+layout(location = 1) in highp vec3 normal;
+layout(location = 2) in mediump vec3 color;
+#endif
+layout(location = 3) in highp vec2 draw_params;
+
+uniform mediump vec4 mono_color;
+uniform highp float rendering_mode;
+
+out highp vec4 fP;
+out highp vec3 fN;
+out mediump vec4 fColor;
+out float gl_ClipDistance[MAX_CLIP_DISTANCES];
+
+#ifdef COMPACT_VERTICES
+highp vec3 decode_octahedron(highp vec2 e)
+{
+  highp vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  highp float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+#endif
+
+void main(void)
+{
+#ifdef COMPACT_VERTICES
+  highp vec4 position = vec4(bbox_min + vertex.xyz * bbox_extent, 1.0);
+  highp vec3 n = decode_octahedron(normal);
+#else
+  highp vec4 position = vertex;
+  highp vec3 n = normal;
+#endif
+
+  fP = mv_matrix * position;
+  fN = normal_sign * (mat3(mv_matrix) * n);
+  fColor = vec4(draw_params.x > 0.5 ? color.rgb : mono_color.rgb, 1.0);
+  gl_PointSize = point_size;
+
+  gl_ClipDistance[0] = (rendering_mode > 0.5 ? -1.0 : 1.0) * dot(clip_planes[0], position);
+  for (int i = 1; i < nb_clip_distances; ++i) {
+    gl_ClipDistance[i] = dot(clip_planes[i], position);
+  }
+
+  gl_Position = mvp_matrix * position;
+}
+)DELIM";
+
+const char fragment_source_face[]=R"DELIM(
+in highp vec4 fP;
+in highp vec3 fN;
+in mediump vec4 fColor;
+
+uniform highp float rendering_mode;
+
+layout(location = 0) out highp vec4 out_color;
+layout(location = 1) out highp vec4 out_accum;      // weighted blended transparency, see Oit.h
+layout(location = 2) out highp float out_revealage;
+
+void main(void)
+{
+  highp vec3 L = light_pos.xyz - fP.xyz;
+  highp vec3 V = -fP.xyz;
+
+  highp vec3 N = normalize(fN);
+  if (flat_shading > 0.5) {
+    // face normal from the screen-space derivatives of the position,
+    // oriented like the interpolated (smooth) normal
+    highp vec3 faceN = normalize(cross(dFdx(fP.xyz), dFdy(fP.xyz)));
+    N = dot(faceN, N) < 0.0 ? -faceN : faceN;
+  }
+  L = normalize(L);
+  V = normalize(V);
+
+  highp vec3 R = reflect(-L, N);
+  highp vec4 diffuse = vec4(max(dot(N,L), 0.0) * light_diff.rgb * fColor.rgb, 1.0);
+  highp vec4 ambient = vec4(light_amb.rgb * fColor.rgb, 1.0);
+  highp vec4 specular = pow(max(dot(R,V), 0.0), spec_power) * light_spec;
+
+  // the outside half of the clipping plane (rendering_mode == 1) is transparent
+  out_color = rendering_mode < 1 ? (diffuse + ambient) :
+                         vec4(diffuse.rgb + ambient.rgb, rendering_transparency);
+
+  // Weight decreasing with the depth, so nearer layers dominate (McGuire and Bavoil, eq. 10)
+  highp float alpha = rendering_transparency * fColor.a;
+  highp float weight = alpha * clamp(3e3 * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, 3e3);
+  out_accum = vec4(out_color.rgb * alpha, alpha) * weight;
+  out_revealage = alpha;
+}
+)DELIM";
+
+/*************CLIPPING PLANE*************/
+
+const char vertex_source_plane[]=R"DELIM(
+layout(location = 0) in highp vec4 vertex;
+
+void main(void)
+{
+  gl_Position = mvp_matrix * clipping_matrix * vertex;
+}
+)DELIM";
+
+const char fragment_source_plane[]=R"DELIM(
+out highp vec4 out_color;
+
+void main(void)
+{
+  out_color = vec4(0.0, 0.0, 0.0, 1.0);
+}
+)DELIM";
+
+/*************TRANSPARENCY*************/
+
+// Triangle covering the viewport, drawn without vertex attribute
+const char vertex_source_fullscreen[]=R"DELIM(
+void main(void)
+{
+  highp vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(2.0 * p - 1.0, 0.0, 1.0);
+}
+)DELIM";
+
+// Weighted average of the transparent layers, blended over the opaque color (sample per sample)
+const char fragment_source_oit_composite[]=R"DELIM(
+layout(binding = 0) uniform highp sampler2DMS accum;
+layout(binding = 1) uniform highp sampler2DMS revealage;
+
+out highp vec4 out_color;
+
+void main(void)
+{
+  ivec2 p = ivec2(gl_FragCoord.xy);
+  highp float reveal = texelFetch(revealage, p, gl_SampleID).r;
+  if (reveal >= 1.0) {
+    // no transparent layer
+    discard;
+  }
+
+  highp vec4 a = texelFetch(accum, p, gl_SampleID);
+  if (isinf(max(max(abs(a.r), abs(a.g)), abs(a.b)))) {
+    // half float overflow
+    a.rgb = vec3(a.a);
+  }
+  out_color = vec4(a.rgb / max(a.a, 1e-5), 1.0 - reveal);
+}
+)DELIM";
+
+const char fragment_source_copy[]=R"DELIM(
+layout(binding = 0) uniform highp sampler2D image;
+
+out highp vec4 out_color;
+
+void main(void)
+{
+  out_color = texelFetch(image, ivec2(gl_FragCoord.xy), 0);
+}
+)DELIM";
+
+/*************POINTS AND LINES*************/
+
+const char vertex_source_pl[]=R"DELIM(
+layout(location = 0) in highp vec4 vertex;
+#ifdef COMPACT_VERTICES
+layout(location = 1) in lowp vec4 color;
+#else
+layout(location = 1) in lowp vec3 color;
+#endif
+layout(location = 3) in highp vec2 draw_params;
+
+uniform lowp vec4 mono_color;
+uniform highp float rendering_mode;
+
+out lowp vec4 fColor;
+out float gl_ClipDistance[MAX_CLIP_DISTANCES];
+
+void main(void)
+{
+#ifdef COMPACT_VERTICES
+  highp vec4 position = vec4(bbox_min + vertex.xyz * bbox_extent, 1.0);
+#else
+  highp vec4 position = vertex;
+#endif
+
+  fColor = vec4(draw_params.x > 0.5 ? color.rgb : mono_color.rgb, 1.0);
+  gl_Position = mvp_matrix * position;
+
+  gl_ClipDistance[0] = (rendering_mode > 0.5 ? -1.0 : 1.0) * dot(clip_planes[0], position);
+  for (int i = 1; i < nb_clip_distances; ++i) {
+    gl_ClipDistance[i] = dot(clip_planes[i], position);
+  }
+
+  gl_PointSize = point_size;
+  if (draw_params.y > 0.0) {
+    // points are enlarged to cover their spacing (point cloud octree),
+    // w is the distance along the view direction (1 in orthographic mode)
+    gl_PointSize = max(point_size, draw_params.y * pixels_per_unit / gl_Position.w);
+  }
+}
+)DELIM";
+
+const char fragment_source_pl[]=R"DELIM(
+in lowp vec4 fColor;
+
+out lowp vec4 out_color;
+
+void main(void)
+{
+  out_color = fColor;
+}
+)DELIM";
+
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <vector>
+
+namespace CGAL::GLFW {
+  /**
+   * Bounding volume hierarchy over the primitives (points, segments or triangles) of one position array.
+   * Nodes are split with the binned surface area heuristic: the primitives are binned by centroid
+   * along the largest axis of their centroids, and the split between two bins minimizing
+   * area(left) * count(left) + area(right) * count(right) is kept, unless a leaf is cheaper.
+   * Subtrees of more than parallelSize primitives are built by separate tasks, then merged.
+   * Children of a node are consecutive and stored after it, so refit() updates the boxes in one
+   * backward pass when the positions move.
+   */
+  class Bvh {
+  public:
+    struct Node {
+      Eigen::AlignedBox3f box;
+      std::uint32_t first; // first child (inner node), or first of m_primitives (leaf)
+      std::uint32_t count; // primitives of a leaf, 0 for an inner node
+    };
+
+    // positions: 3 floats per vertex, primitiveSize consecutive vertices per primitive
+    void build(const float* positions, std::size_t nbPrimitives, int primitiveSize,
+               std::size_t leafSize, std::size_t parallelSize) {
+      m_positions = positions;
+      m_primitive_size = primitiveSize;
+      m_leaf_size = std::max<std::size_t>(leafSize, 1);
+      m_parallel_size = std::max<std::size_t>(parallelSize, 1024);
+
+      m_nodes.clear();
+      m_primitives.resize(nbPrimitives);
+      if (nbPrimitives == 0) return;
+
+      // Boxes of the primitives, partitioned along with their index during the build
+      std::vector<Reference> references(nbPrimitives);
+      for (std::size_t p = 0; p < nbPrimitives; ++p) {
+        references[p] = {primitive_box(static_cast<std::uint32_t>(p)), static_cast<std::uint32_t>(p)};
+      }
+
+      m_nodes.reserve(2 * nbPrimitives / m_leaf_size + 1);
+      m_nodes.push_back(Node());
+      build_node(references.data(), m_nodes, 0, 0, static_cast<std::uint32_t>(nbPrimitives));
+
+      for (std::size_t i = 0; i < nbPrimitives; ++i) { m_primitives[i] = references[i].primitive; }
+    }
+
+    // Boxes updated for new positions of the same primitives
+    void refit(const float* positions) {
+      m_positions = positions;
+      for (std::size_t n = m_nodes.size(); n-- > 0;) {
+        Node& node = m_nodes[n];
+        if (node.count > 0) {
+          node.box = range_box(node.first, node.first + node.count);
+        } else {
+          node.box = m_nodes[node.first].box.merged(m_nodes[node.first + 1].box);
+        }
+      }
+    }
+
+    void clear() {
+      m_nodes.clear();
+      m_primitives.clear();
+    }
+
+    bool empty() const { return m_nodes.empty(); }
+    std::size_t nb_primitives() const { return m_primitives.size(); }
+    const std::vector<Node>& nodes() const { return m_nodes; }
+
+    /*
+     * Visits the primitives of the leaves whose box, enlarged by expansion, is crossed by the ray
+     * origin + t direction for t in [0, tMax], nearest boxes first. visit(primitive) may lower tMax
+     * (a reference to the caller's variable) to prune the rest of the traversal.
+     */
+    template <class Visit>
+    void traverse(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction, float expansion,
+                  const float& tMax, Visit visit) const {
+      if (m_nodes.empty()) return;
+
+      const Eigen::Vector3f inverse = direction.cwiseInverse();
+      const Eigen::Vector3f margin = Eigen::Vector3f::Constant(expansion);
+      auto entry = [&](const Node& node) {
+        const Eigen::Vector3f t0 = (node.box.min() - margin - origin).cwiseProduct(inverse);
+        const Eigen::Vector3f t1 = (node.box.max() + margin - origin).cwiseProduct(inverse);
+        const float tNear = std::max(t0.cwiseMin(t1).maxCoeff(), 0.f);
+        const float tFar = std::min(t0.cwiseMax(t1).minCoeff(), tMax);
+        return tNear <= tFar ? tNear : std::numeric_limits<float>::infinity();
+      };
+
+      std::vector<std::uint32_t> stack;
+      stack.reserve(64);
+      if (entry(m_nodes[0]) < std::numeric_limits<float>::infinity()) { stack.push_back(0); }
+
+      while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (node.count > 0) {
+          for (std::uint32_t i = node.first; i < node.first + node.count; ++i) { visit(m_primitives[i]); }
+          continue;
+        }
+
+        const float tLeft = entry(m_nodes[node.first]);
+        const float tRight = entry(m_nodes[node.first + 1]);
+        const std::uint32_t left = node.first, right = node.first + 1;
+        const bool leftFirst = tLeft <= tRight;
+        const float tFirst = leftFirst ? tLeft : tRight, tSecond = leftFirst ? tRight : tLeft;
+
+        // The nearest child is popped first
+        if (tSecond < std::numeric_limits<float>::infinity()) { stack.push_back(leftFirst ? right : left); }
+        if (tFirst < std::numeric_limits<float>::infinity()) { stack.push_back(leftFirst ? left : right); }
+      }
+    }
+
+  private:
+    static const int NB_BINS = 16;
+
+    struct Reference {
+      Eigen::AlignedBox3f box;
+      std::uint32_t primitive;
+    };
+
+    Eigen::Vector3f vertex(std::uint32_t primitive, int k) const {
+      const float* v = m_positions + 3 * (static_cast<std::size_t>(primitive) * m_primitive_size + k);
+      return Eigen::Vector3f(v[0], v[1], v[2]);
+    }
+
+    Eigen::AlignedBox3f primitive_box(std::uint32_t primitive) const {
+      Eigen::AlignedBox3f box;
+      for (int k = 0; k < m_primitive_size; ++k) { box.extend(vertex(primitive, k)); }
+      return box;
+    }
+
+    Eigen::AlignedBox3f range_box(std::uint32_t begin, std::uint32_t end) const {
+      Eigen::AlignedBox3f box;
+      for (std::uint32_t i = begin; i < end; ++i) { box.extend(primitive_box(m_primitives[i])); }
+      return box;
+    }
+
+    static float half_area(const Eigen::AlignedBox3f& box) {
+      if (box.isEmpty()) return 0.f;
+      const Eigen::Vector3f d = box.sizes();
+      return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+    }
+
+    // Builds the subtree of nodes[n] over references[begin, end), nodes are appended to nodes
+    void build_node(Reference* references, std::vector<Node>& nodes, std::uint32_t n, std::uint32_t begin, std::uint32_t end) {
+      Eigen::AlignedBox3f box, centroids;
+      for (std::uint32_t i = begin; i < end; ++i) {
+        box.extend(references[i].box);
+        centroids.extend(references[i].box.center());
+      }
+      nodes[n] = {box, begin, end - begin};
+
+      const std::uint32_t count = end - begin;
+      if (count <= m_leaf_size) return;
+
+      int axis;
+      const float extent = centroids.sizes().maxCoeff(&axis);
+      if (!(extent > 0.f)) return; // all centroids at the same place
+
+      // Binning
+      const float origin = centroids.min()[axis], scale = NB_BINS / extent;
+      auto binOf = [&](const Reference& reference) {
+        const float c = 0.5f * (reference.box.min()[axis] + reference.box.max()[axis]);
+        return std::min(NB_BINS - 1, static_cast<int>((c - origin) * scale));
+      };
+      Eigen::AlignedBox3f bins[NB_BINS];
+      std::uint32_t counts[NB_BINS] = {};
+      for (std::uint32_t i = begin; i < end; ++i) {
+        const int b = binOf(references[i]);
+        bins[b].extend(references[i].box);
+        ++counts[b];
+      }
+
+      // Sweeps: cost of the split after bin b
+      float leftCosts[NB_BINS - 1];
+      Eigen::AlignedBox3f accumulated;
+      std::uint32_t accumulatedCount = 0;
+      for (int b = 0; b < NB_BINS - 1; ++b) {
+        accumulated.extend(bins[b]);
+        accumulatedCount += counts[b];
+        leftCosts[b] = half_area(accumulated) * accumulatedCount;
+      }
+      int bestSplit = -1;
+      float bestCost = std::numeric_limits<float>::infinity();
+      accumulated.setEmpty();
+      accumulatedCount = 0;
+      for (int b = NB_BINS - 1; b > 0; --b) {
+        accumulated.extend(bins[b]);
+        accumulatedCount += counts[b];
+        const float cost = leftCosts[b - 1] + half_area(accumulated) * accumulatedCount;
+        if (accumulatedCount < count && cost < bestCost) {
+          bestCost = cost;
+          bestSplit = b;
+        }
+      }
+
+      // A split costs one more box test (about one primitive test) per primitive
+      const float leafCost = half_area(box) * count;
+      if (bestSplit < 0 || (bestCost + half_area(box) >= leafCost && count <= 4 * m_leaf_size)) return;
+
+      Reference* middle = std::partition(references + begin, references + end,
+                                         [&](const Reference& reference) { return binOf(reference) < bestSplit; });
+      const std::uint32_t split = static_cast<std::uint32_t>(middle - references);
+      if (split == begin || split == end) return;
+
+      const std::uint32_t children = static_cast<std::uint32_t>(nodes.size());
+      nodes[n].first = children;
+      nodes[n].count = 0;
+      nodes.push_back(Node());
+      nodes.push_back(Node());
+
+      if (count < m_parallel_size) {
+        build_node(references, nodes, children, begin, split);
+        build_node(references, nodes, children + 1, split, end);
+        return;
+      }
+
+      // The left subtree in its own array on another thread, then moved after the right one
+      std::future<std::vector<Node>> left = std::async(std::launch::async, [this, references, begin, split] {
+        std::vector<Node> subtree(1);
+        build_node(references, subtree, 0, begin, split);
+        return subtree;
+      });
+      build_node(references, nodes, children + 1, split, end);
+
+      const std::vector<Node> subtree = left.get();
+      const std::uint32_t offset = static_cast<std::uint32_t>(nodes.size()) - 1; // subtree[i] -> nodes[offset + i], i > 0
+      auto moved = [offset](Node node) {
+        if (node.count == 0) { node.first += offset; }
+        return node;
+      };
+      nodes[children] = moved(subtree[0]);
+      for (std::size_t i = 1; i < subtree.size(); ++i) { nodes.push_back(moved(subtree[i])); }
+    }
+
+    const float* m_positions = nullptr;
+    int m_primitive_size = 1;
+    std::size_t m_leaf_size = 4;
+    std::size_t m_parallel_size = 1 << 16;
+
+    std::vector<Node> m_nodes;
+    std::vector<std::uint32_t> m_primitives; // leaf order -> primitive
+  };
+}
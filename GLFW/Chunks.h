@@ -0,0 +1,139 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace CGAL::GLFW {
+  // A range of consecutive vertices of a reordered array and its bounding box
+  struct Chunk {
+    std::size_t first;
+    std::size_t count;
+    Eigen::AlignedBox3f box;
+  };
+
+  /**
+   * Spatial partition of the primitives (points, segments or triangles) of one array.
+   * Primitives are split recursively at the median of their centroids along the longest
+   * axis (kd-tree over the primitives) until a node holds at most maxPrimitives of them.
+   * The leaves are the chunks, in the order of the new vertex array.
+   */
+  class Chunk_partition {
+  public:
+    // positions: 3 floats per vertex, primitiveSize consecutive vertices per primitive
+    void build(const std::vector<float>& positions, int primitiveSize, std::size_t maxPrimitives) {
+      const float* data = positions.data();
+      build(positions.size() / (3 * primitiveSize), primitiveSize, maxPrimitives,
+        [data, primitiveSize](std::size_t p, int k) {
+          const float* v = data + 3 * (p * primitiveSize + k);
+          return Eigen::Vector3f(v[0], v[1], v[2]);
+        });
+    }
+
+    // vertexOf(p, k) returns the k-th vertex of the primitive p (for indexed primitives)
+    template <class VertexOf>
+    void build(std::size_t nbPrimitives, int primitiveSize, std::size_t maxPrimitives, VertexOf vertexOf) {
+      m_primitive_size = primitiveSize;
+      m_max_primitives = std::max<std::size_t>(maxPrimitives, 1);
+
+      m_centroids.resize(nbPrimitives);
+      m_primitives.resize(nbPrimitives);
+      for (std::size_t p = 0; p < nbPrimitives; ++p) {
+        Eigen::Vector3f c = Eigen::Vector3f::Zero();
+        for (int k = 0; k < primitiveSize; ++k) {
+          c += vertexOf(p, k);
+        }
+        m_centroids[p] = c / float(primitiveSize);
+        m_primitives[p] = static_cast<std::uint32_t>(p);
+      }
+
+      m_chunks.clear();
+      if (nbPrimitives > 0) {
+        split(0, nbPrimitives, vertexOf);
+      }
+
+      m_order.resize(nbPrimitives * primitiveSize);
+      m_inverse_order.resize(nbPrimitives * primitiveSize);
+      for (std::size_t p = 0; p < nbPrimitives; ++p) {
+        for (int k = 0; k < primitiveSize; ++k) {
+          m_order[p * primitiveSize + k] = m_primitives[p] * primitiveSize + k;
+          m_inverse_order[m_primitives[p] * primitiveSize + k] = static_cast<std::uint32_t>(p * primitiveSize + k);
+        }
+      }
+
+      m_centroids.clear();
+      m_centroids.shrink_to_fit();
+    }
+
+    // Bounding boxes of the chunks with a vertex in [first, last) (new indices) computed again from positions,
+    // the primitives keep their order
+    void refit(const std::vector<float>& positions, std::size_t first, std::size_t last) {
+      for (Chunk& chunk : m_chunks) {
+        if (chunk.first + chunk.count <= first || chunk.first >= last) continue;
+
+        chunk.box.setEmpty();
+        for (std::size_t v = chunk.first; v < chunk.first + chunk.count; ++v) {
+          chunk.box.extend(Eigen::Vector3f::Map(positions.data() + 3 * std::size_t(m_order[v])));
+        }
+      }
+    }
+
+    void clear() {
+      m_primitives.clear();
+      m_order.clear();
+      m_inverse_order.clear();
+      m_chunks.clear();
+    }
+
+    bool empty() const { return m_chunks.empty(); }
+
+    // new primitive index -> primitive index in the original array
+    const std::vector<std::uint32_t>& primitive_order() const { return m_primitives; }
+    // new vertex index -> vertex index in the original array
+    const std::vector<std::uint32_t>& vertex_order() const { return m_order; }
+    // vertex index in the original array -> new vertex index
+    const std::vector<std::uint32_t>& inverse_vertex_order() const { return m_inverse_order; }
+    const std::vector<Chunk>& chunks() const { return m_chunks; }
+
+  private:
+    template <class VertexOf>
+    void split(std::size_t begin, std::size_t end, VertexOf& vertexOf) {
+      if (end - begin <= m_max_primitives) {
+        Chunk chunk {begin * m_primitive_size, (end - begin) * m_primitive_size, Eigen::AlignedBox3f()};
+        for (std::size_t p = begin; p < end; ++p) {
+          for (int k = 0; k < m_primitive_size; ++k) {
+            chunk.box.extend(vertexOf(m_primitives[p], k));
+          }
+        }
+        m_chunks.push_back(chunk);
+        return;
+      }
+
+      Eigen::AlignedBox3f box;
+      for (std::size_t p = begin; p < end; ++p) {
+        box.extend(m_centroids[m_primitives[p]]);
+      }
+
+      int axis;
+      box.sizes().maxCoeff(&axis);
+
+      const std::size_t middle = begin + (end - begin) / 2;
+      std::nth_element(m_primitives.begin() + begin, m_primitives.begin() + middle, m_primitives.begin() + end,
+        [this, axis](std::uint32_t a, std::uint32_t b) { return m_centroids[a][axis] < m_centroids[b][axis]; });
+
+      split(begin, middle, vertexOf);
+      split(middle, end, vertexOf);
+    }
+
+    int m_primitive_size = 1;
+    std::size_t m_max_primitives = 1;
+
+    std::vector<Eigen::Vector3f> m_centroids;
+    std::vector<std::uint32_t> m_primitives;
+    std::vector<std::uint32_t> m_order;
+    std::vector<std::uint32_t> m_inverse_order;
+    std::vector<Chunk> m_chunks;
+  };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace CGAL::GLFW {
+  /**
+   * Triangles written by their owner straight into the mapped buffers of the viewer, without the arrays of
+   * a Graphics_scene (see Basic_Viewer::direct_mesh). Vertices are interleaved: position, normal, then color
+   * if some triangles are colored, 3 floats each. Triangles are 3 indices into them, the mono ones (drawn with
+   * the mono color of the faces) first.
+   * The work is split into blocks: write_block writes the vertices and the triangles of one block at their
+   * final place, it is called concurrently for different blocks.
+   */
+  struct Direct_mesh {
+    std::size_t nb_vertices = 0;
+    std::size_t nb_triangles = 0;
+    std::size_t nb_mono_triangles = 0;
+    Eigen::AlignedBox3f box; // of the positions
+
+    std::size_t nb_blocks = 0;
+    std::function<void(std::size_t block, float* vertices, std::uint32_t* indices)> write_block;
+
+    bool colored() const { return nb_mono_triangles < nb_triangles; }
+    std::size_t vertex_floats() const { return colored() ? 9 : 6; }
+
+    // All the blocks, on one thread per core
+    void write(float* vertices, std::uint32_t* indices) const {
+      std::atomic<std::size_t> next {0};
+      auto worker = [&]() {
+        for (std::size_t b = next++; b < nb_blocks; b = next++) { write_block(b, vertices, indices); }
+      };
+
+      const std::size_t nbThreads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), nb_blocks);
+      std::vector<std::thread> threads;
+      for (std::size_t i = 1; i < nbThreads; ++i) { threads.emplace_back(worker); }
+      worker();
+      for (std::thread& thread : threads) { thread.join(); }
+    }
+  };
+}
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Image_encoder.h"
+
+namespace CGAL::GLFW {
+  // RGB pixels of a frame read back from the GPU, rows from top to bottom
+  struct Captured_frame {
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    std::string path; // image file, empty for a frame of the stream
+  };
+
+  /**
+   * Encodes and writes the captured frames on worker threads, started with the first frame.
+   * Frames are either image files (see Image_encoder) or frames of a Y4M stream (4:4:4, BT.601), the frames of the
+   * stream are converted in parallel and written in the order they were pushed.
+   * At most queueSize frames wait for a worker, push blocks beyond that.
+   */
+  class Frame_writer {
+  public:
+    Frame_writer(unsigned nbThreads, std::size_t queueSize, const Image_encoder& encoder) :
+      m_nb_threads(std::max(nbThreads, 1u)), m_queue_size(std::max<std::size_t>(queueSize, 1)), m_encoder(encoder) {}
+
+    ~Frame_writer() {
+      close_stream();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+      }
+      m_work.notify_all();
+      for (std::thread& thread : m_threads) { thread.join(); }
+    }
+
+    // Frames without path are appended to this Y4M file, its size is the size of its first frame
+    bool open_stream(const std::string& path, double fps) {
+      close_stream();
+      m_stream.open(path, std::ios::binary);
+      m_stream_fps = fps;
+      m_stream_width = m_stream_height = 0;
+      m_pushed_stream_frames = m_written_stream_frames = 0;
+      return m_stream.is_open();
+    }
+
+    void close_stream() {
+      if (!m_stream.is_open()) return;
+      wait();
+      m_stream.close();
+    }
+
+    // Settings of the images, not to be changed while frames are written
+    Image_encoder& encoder() { return m_encoder; }
+    const Image_encoder& encoder() const { return m_encoder; }
+
+    // Storage for the pixels of the next frame, recycled from the written frames
+    std::vector<unsigned char> acquire_buffer() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_free_buffers.empty()) return {};
+
+      std::vector<unsigned char> buffer = std::move(m_free_buffers.back());
+      m_free_buffers.pop_back();
+      return buffer;
+    }
+
+    void push(Captured_frame&& frame) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      const bool isStreamFrame = frame.path.empty();
+      if (isStreamFrame) {
+        if (!m_stream.is_open()) return;
+        if (m_stream_width == 0) {
+          m_stream_width = frame.width;
+          m_stream_height = frame.height;
+        } else if (frame.width != m_stream_width || frame.height != m_stream_height) {
+          std::cerr << "Frame size changed while recording, frame dropped" << std::endl;
+          return;
+        }
+      }
+
+      if (m_threads.empty()) {
+        for (unsigned i = 0; i < m_nb_threads; ++i) { m_threads.emplace_back(&Frame_writer::run, this); }
+      }
+
+      m_space.wait(lock, [this] { return m_queue.size() < m_queue_size; });
+      m_queue.push_back({std::move(frame), isStreamFrame ? m_pushed_stream_frames++ : 0});
+      ++m_pending;
+      m_work.notify_one();
+    }
+
+    // Returns when all the pushed frames are written
+    void wait() {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done.wait(lock, [this] { return m_pending == 0; });
+    }
+
+  private:
+    struct Job {
+      Captured_frame frame;
+      std::size_t index; // in the stream
+    };
+
+    void run() {
+      std::vector<unsigned char> yuv;
+      for (;;) {
+        Job job;
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_work.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+          if (m_queue.empty()) return;
+
+          job = std::move(m_queue.front());
+          m_queue.pop_front();
+        }
+        m_space.notify_one();
+
+        const Captured_frame& frame = job.frame;
+        if (!frame.path.empty()) {
+          if (!m_encoder.write(frame.path, frame.pixels.data(), frame.width, frame.height)) {
+            std::cerr << "Could not write " << frame.path << std::endl;
+          }
+        } else {
+          to_yuv444(frame, yuv);
+
+          // The frames of the stream are written in order, by the worker holding the next one
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_written.wait(lock, [&] { return m_written_stream_frames == job.index; });
+          lock.unlock();
+
+          if (job.index == 0) {
+            m_stream << "YUV4MPEG2 W" << frame.width << " H" << frame.height
+                     << " F" << static_cast<long>(m_stream_fps * 1000 + 0.5) << ":1000 Ip A1:1 C444\n";
+          }
+          m_stream << "FRAME\n";
+          m_stream.write(reinterpret_cast<const char*>(yuv.data()), yuv.size());
+
+          lock.lock();
+          ++m_written_stream_frames;
+          m_written.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_buffers.push_back(std::move(job.frame.pixels));
+        if (--m_pending == 0) { m_done.notify_all(); }
+      }
+    }
+
+    // Planar Y, Cb, Cr in video range
+    static void to_yuv444(const Captured_frame& frame, std::vector<unsigned char>& yuv) {
+      const std::size_t nbPixels = static_cast<std::size_t>(frame.width) * frame.height;
+      yuv.resize(3 * nbPixels);
+
+      unsigned char* y = yuv.data();
+      unsigned char* u = y + nbPixels;
+      unsigned char* v = u + nbPixels;
+      const unsigned char* rgb = frame.pixels.data();
+      for (std::size_t i = 0; i < nbPixels; ++i, rgb += 3) {
+        const int r = rgb[0], g = rgb[1], b = rgb[2];
+        y[i] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[i] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[i] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+      }
+    }
+
+    unsigned m_nb_threads;
+    std::size_t m_queue_size;
+    std::vector<std::thread> m_threads;
+    Image_encoder m_encoder;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work;    // a job was queued or the writer stops
+    std::condition_variable m_space;   // a job left the queue
+    std::condition_variable m_done;    // all the jobs are written
+    std::condition_variable m_written; // a frame of the stream was written
+    std::deque<Job> m_queue;
+    std::size_t m_pending = 0;         // queued or being written
+    bool m_stop = false;
+    std::vector<std::vector<unsigned char>> m_free_buffers;
+
+    std::ofstream m_stream;
+    double m_stream_fps = 0;
+    int m_stream_width = 0;
+    int m_stream_height = 0;
+    std::size_t m_pushed_stream_frames = 0;
+    std::size_t m_written_stream_frames = 0;
+  };
+
+  /**
+   * Ring of pixel pack buffers: glReadPixels only queues the copy of a frame into the next
+   * buffer of the ring, the copy is mapped once its fence is signaled (usually one or two
+   * frames later) and handed to a Frame_writer. The render thread only waits when all the
+   * buffers of the ring are still in flight.
+   */
+  class Pbo_readback {
+  public:
+    // The OpenGL context must be current
+    void init(std::size_t ringSize) {
+      if (!m_slots.empty()) return;
+
+      m_slots.resize(std::max<std::size_t>(ringSize, 1));
+      for (Slot& slot : m_slots) { glGenBuffers(1, &slot.buffer); }
+      m_next = 0;
+    }
+
+    // Pending readbacks are lost, see flush
+    void destroy() {
+      for (Slot& slot : m_slots) {
+        if (slot.fence != nullptr) { glDeleteSync(slot.fence); }
+        glDeleteBuffers(1, &slot.buffer);
+      }
+      m_slots.clear();
+    }
+
+    bool is_initialized() const { return !m_slots.empty(); }
+    std::size_t size() const { return m_slots.size(); }
+
+    // Queues the readback of the color buffer of the read framebuffer, path is empty for a frame of the stream.
+    // With a target, the frame is copied there instead of being handed to the writer.
+    // Waits for the oldest readback when the ring is full: once it returns, the readback queued size()
+    // calls before is retrieved.
+    void read(int width, int height, const std::string& path, Frame_writer& writer, Captured_frame* target = nullptr) {
+      Slot& slot = m_slots[m_next];
+      if (slot.fence != nullptr) { retrieve(slot, writer); }
+
+      const std::size_t size = static_cast<std::size_t>(width) * height * 3;
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      if (size > slot.capacity) {
+        slot.capacity = size;
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+      }
+
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      slot.width = width;
+      slot.height = height;
+      slot.path = path;
+      slot.target = target;
+      m_next = (m_next + 1) % m_slots.size();
+    }
+
+    // Hands the finished readbacks to the writer, in order, without waiting
+    void poll(Frame_writer& writer) {
+      for (std::size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot = m_slots[(m_next + i) % m_slots.size()];
+        if (slot.fence == nullptr) continue;
+
+        const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+        retrieve(slot, writer);
+      }
+    }
+
+    // Hands all the pending readbacks to the writer
+    void flush(Frame_writer& writer) {
+      for (std::size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot = m_slots[(m_next + i) % m_slots.size()];
+        if (slot.fence != nullptr) { retrieve(slot, writer); }
+      }
+    }
+
+  private:
+    struct Slot {
+      GLuint buffer = 0;
+      std::size_t capacity = 0; // in bytes
+      GLsync fence = nullptr;   // readback in flight
+      int width = 0;
+      int height = 0;
+      std::string path;
+      Captured_frame* target = nullptr;
+    };
+
+    // Waits for the readback of the slot and copies it, rows are flipped to top to bottom
+    void retrieve(Slot& slot, Frame_writer& writer) {
+      while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+
+      Captured_frame local;
+      Captured_frame& frame = slot.target != nullptr ? *slot.target : local;
+      if (slot.target == nullptr) { frame.pixels = writer.acquire_buffer(); }
+      frame.width = slot.width;
+      frame.height = slot.height;
+      frame.path = std::move(slot.path);
+
+      const std::size_t rowSize = static_cast<std::size_t>(slot.width) * 3;
+      frame.pixels.resize(rowSize * slot.height);
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      const unsigned char* data = static_cast<const unsigned char*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowSize * slot.height, GL_MAP_READ_BIT));
+      if (data != nullptr) {
+        for (int row = 0; row < slot.height; ++row) {
+          std::memcpy(&frame.pixels[row * rowSize], data + (slot.height - 1 - row) * rowSize, rowSize);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+      if (data != nullptr && slot.target == nullptr) { writer.push(std::move(frame)); }
+    }
+
+    std::vector<Slot> m_slots;
+    std::size_t m_next = 0; // next slot written, the oldest in flight
+  };
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace CGAL::GLFW {
+  // Rolling statistics of one section, in milliseconds
+  struct Timing_stats {
+    std::size_t count = 0; // samples in the window
+    double min = 0;
+    double mean = 0;
+    double p95 = 0;
+  };
+
+  /**
+   * Timings of the GPU passes (GL_TIME_ELAPSED queries) and of some CPU sections of the viewer,
+   * kept over the last window samples of each section.
+   * Queries are double-buffered: the result of a pass is read two frames later, when it is
+   * available, so reading never stalls the pipeline. A pass whose previous query is still
+   * pending is not measured for this frame.
+   */
+  class Frame_profiler {
+  public:
+    enum Section {
+      // GPU passes
+      VERTICES=0,
+      EDGES,
+      FACES,
+      FACES_INSIDE,          // clipping plane passes, see Basic_Viewer::draw_faces
+      FACES_OUTSIDE,
+      FACES_INSIDE_AGAIN,
+      RAYS,
+      LINES,
+      CLIPPING_PLANE,
+      // CPU sections
+      HANDLE_EVENTS,         // only while animating, the idle wait is not measured
+      UPDATE_UNIFORMS,
+      LOAD_SCENE,
+      RENDER_SCENE,          // whole CPU side of a frame
+      NB_SECTIONS
+    };
+    static const int NB_GPU_SECTIONS = CLIPPING_PLANE + 1;
+
+    static const char* name(int section) {
+      static const char* names[NB_SECTIONS] = {
+        "vertices", "edges", "faces", "faces inside", "faces outside", "faces inside again",
+        "rays", "lines", "clipping plane",
+        "handle_events", "update_uniforms", "load_scene", "render_scene"
+      };
+      return names[section];
+    }
+    static bool is_gpu(int section) { return section < NB_GPU_SECTIONS; }
+
+    // Measures the CPU time of its scope
+    class Cpu_timer {
+    public:
+      Cpu_timer(Frame_profiler& profiler, int section, bool enabled = true) :
+        m_profiler(profiler), m_section(section), m_enabled(enabled && profiler.enabled()),
+        m_start(std::chrono::steady_clock::now()) {}
+
+      ~Cpu_timer() {
+        if (!m_enabled) return;
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+        m_profiler.add_sample(m_section, elapsed.count());
+      }
+
+    private:
+      Frame_profiler& m_profiler;
+      int m_section;
+      bool m_enabled;
+      std::chrono::steady_clock::time_point m_start;
+    };
+
+    explicit Frame_profiler(std::size_t window, bool enabled = false) : 
+      m_enabled(enabled), m_window(std::max<std::size_t>(window, 1)) {}
+
+    void enable(bool b) { m_enabled = b; }
+    bool enabled() const { return m_enabled; }
+
+    // Query objects of the GPU passes, the OpenGL 4.3 context must be current.
+    // Queries belong to one context: they are created again for each new context.
+    void init_gpu_timers() {
+      release_gpu_timers();
+      glGenQueries(2 * NB_GPU_SECTIONS, &m_queries[0][0]);
+      m_has_gpu_timers = true;
+    }
+
+    // Before the context of the queries is destroyed, while it is still current
+    void release_gpu_timers() {
+      if (m_has_gpu_timers) { glDeleteQueries(2 * NB_GPU_SECTIONS, &m_queries[0][0]); }
+      std::fill(&m_queries[0][0], &m_queries[0][0] + 2 * NB_GPU_SECTIONS, 0u);
+      std::fill(&m_pending[0][0], &m_pending[0][0] + 2 * NB_GPU_SECTIONS, false);
+      m_active = -1;
+      m_has_gpu_timers = false;
+    }
+
+    // Collects the available results of the queries issued two frames ago
+    void begin_frame() {
+      if (!m_enabled || !m_has_gpu_timers) return;
+
+      m_set = 1 - m_set;
+      for (int section = 0; section < NB_GPU_SECTIONS; ++section) {
+        if (!m_pending[m_set][section]) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[m_set][section], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(m_queries[m_set][section], GL_QUERY_RESULT, &nanoseconds);
+        add_sample(section, nanoseconds * 1e-6);
+        m_pending[m_set][section] = false;
+      }
+    }
+
+    // GPU passes cannot be nested
+    void begin_gpu(int section) {
+      m_active = -1;
+      if (!m_enabled || !m_has_gpu_timers || m_pending[m_set][section]) return;
+
+      glBeginQuery(GL_TIME_ELAPSED, m_queries[m_set][section]);
+      m_active = section;
+    }
+
+    void end_gpu() {
+      if (m_active < 0) return;
+
+      glEndQuery(GL_TIME_ELAPSED);
+      m_pending[m_set][m_active] = true;
+      m_active = -1;
+    }
+
+    void add_sample(int section, double milliseconds) {
+      std::vector<double>& samples = m_samples[section];
+      if (samples.size() < m_window) {
+        samples.push_back(milliseconds);
+      } else {
+        samples[m_next[section]] = milliseconds;
+      }
+      m_next[section] = (m_next[section] + 1) % m_window;
+    }
+
+    void clear() {
+      for (int section = 0; section < NB_SECTIONS; ++section) {
+        m_samples[section].clear();
+        m_next[section] = 0;
+      }
+    }
+
+    Timing_stats stats(int section) const {
+      Timing_stats result;
+      const std::vector<double>& samples = m_samples[section];
+      if (samples.empty()) return result;
+
+      m_sorted = samples;
+      std::sort(m_sorted.begin(), m_sorted.end());
+
+      result.count = m_sorted.size();
+      result.min = m_sorted.front();
+      for (double sample : m_sorted) { result.mean += sample; }
+      result.mean /= m_sorted.size();
+      result.p95 = m_sorted[std::min(m_sorted.size() - 1, static_cast<std::size_t>(0.95 * m_sorted.size()))];
+      return result;
+    }
+
+    // Table of the sections with samples
+    void print(std::ostream& out) const {
+      char line[128];
+      std::snprintf(line, sizeof(line), "%-24s %8s %9s %9s %9s\n", "section (ms)", "samples", "min", "mean", "p95");
+      out << line;
+      for (int section = 0; section < NB_SECTIONS; ++section) {
+        const Timing_stats s = stats(section);
+        if (s.count == 0) continue;
+
+        std::snprintf(line, sizeof(line), "%-24s %8zu %9.3f %9.3f %9.3f\n", label(section).c_str(), s.count, s.min, s.mean, s.p95);
+        out << line;
+      }
+      out << std::endl;
+    }
+
+    static void write_csv_header(std::ostream& out) {
+      out << "time_s,section,samples,min_ms,mean_ms,p95_ms\n";
+    }
+
+    // One row per section with samples, time is the time of the dump
+    void write_csv(std::ostream& out, double time) const {
+      for (int section = 0; section < NB_SECTIONS; ++section) {
+        const Timing_stats s = stats(section);
+        if (s.count == 0) continue;
+
+        out << time << ',' << label(section) << ',' << s.count << ','
+            << s.min << ',' << s.mean << ',' << s.p95 << '\n';
+      }
+      out.flush();
+    }
+
+  private:
+    static std::string label(int section) {
+      return std::string(name(section)) + (is_gpu(section) ? " (GPU)" : " (CPU)");
+    }
+
+    bool m_enabled = false;
+    std::size_t m_window;
+
+    bool m_has_gpu_timers = false;
+    GLuint m_queries[2][NB_GPU_SECTIONS] = {};
+    bool m_pending[2][NB_GPU_SECTIONS] = {}; // query issued, result not read yet
+    int m_set = 0;                           // query set of the current frame
+    int m_active = -1;                       // section of the running query
+
+    std::vector<double> m_samples[NB_SECTIONS]; // ring of the last m_window samples
+    std::size_t m_next[NB_SECTIONS] = {};
+    mutable std::vector<double> m_sorted;
+  };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <CGAL/Graphics_scene.h>
+#include <CGAL/version.h>
+
+#include <type_traits>
+#include <vector>
+
+// Graphics_scene only adds elements one by one (add_point, add_segment, face_begin...), updating the bounding box
+// at each point. The parallel builder of draw_surface_mesh.h and Scene_stream fill, append or swap whole arrays
+// instead, through the protected members arrays and m_bounding_box of Graphics_scene: this header is the only
+// place relying on them. They are checked for the CGAL versions below, define
+// CGAL_GLFW_UNCHECKED_GRAPHICS_SCENE to use them with another one (the static_asserts still apply). Otherwise
+// CGAL_GLFW_GRAPHICS_SCENE_ACCESS is 0 and Graphics_scene_access is not defined: scenes are built serially by
+// add_to_graphics_scene_for_fg, draw() does not use direct meshes and the chunks of a Scene_stream are not drawn.
+#if defined(CGAL_GLFW_UNCHECKED_GRAPHICS_SCENE) || \
+    (CGAL_VERSION_NR >= CGAL_VERSION_NUMBER(6, 0, 0) && CGAL_VERSION_NR < CGAL_VERSION_NUMBER(6, 2, 0))
+#define CGAL_GLFW_GRAPHICS_SCENE_ACCESS 1
+#else
+#define CGAL_GLFW_GRAPHICS_SCENE_ACCESS 0
+#endif
+
+#if CGAL_GLFW_GRAPHICS_SCENE_ACCESS
+namespace CGAL::GLFW {
+  // Names the protected arrays and bounding box of a Graphics_scene, it is never instantiated
+  struct Graphics_scene_access : public Graphics_scene {
+    static std::vector<float>& array(Graphics_scene& scene, int index) {
+      return (scene.*(&Graphics_scene_access::arrays))[index];
+    }
+
+    static CGAL::Bbox_3& bounding_box(Graphics_scene& scene) {
+      return scene.*(&Graphics_scene_access::m_bounding_box);
+    }
+
+  private:
+    Graphics_scene_access() = delete;
+
+    static_assert(std::is_same<std::remove_all_extents_t<decltype(Graphics_scene_access::arrays)>, std::vector<float>>::value &&
+                  std::extent<decltype(Graphics_scene_access::arrays)>::value == Graphics_scene::LAST_INDEX,
+                  "Graphics_scene::arrays is not an array of LAST_INDEX std::vector<float>");
+    static_assert(std::is_same<decltype(Graphics_scene_access::m_bounding_box), CGAL::Bbox_3>::value,
+                  "Graphics_scene::m_bounding_box is not a CGAL::Bbox_3");
+  };
+}
+#endif
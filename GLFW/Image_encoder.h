@@ -0,0 +1,538 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace CGAL::GLFW {
+  enum Image_format {
+    IMAGE_PNG=0,
+    IMAGE_QOI,   // https://qoiformat.org
+    IMAGE_PPM,   // binary P6
+    IMAGE_PAM,   // P7, TUPLTYPE RGB
+    IMAGE_RGBA   // "RGBA", width, height (32-bit little endian), then the RGBA rows from top to bottom
+  };
+
+  class Image_stream;
+
+  /**
+   * Writes 8-bit RGB images (rows from top to bottom), the format is chosen from the file extension
+   * (.png, .qoi, .ppm, .pam, .rgba, PNG for the other ones).
+   * PNG images are compressed in strips of rows on several threads: each strip is an independent
+   * run of fixed Huffman deflate blocks ended by an empty stored block, so that the strips are
+   * concatenated into one zlib stream, each one in its own IDAT chunk.
+   */
+  class Image_encoder {
+  public:
+    // level 0: stored, 1 (fastest) to 9 (smallest)
+    Image_encoder(int pngLevel, unsigned nbThreads) : m_png_level(std::clamp(pngLevel, 0, 9)), m_nb_threads(nbThreads) {
+      if (m_nb_threads == 0) { m_nb_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    }
+
+    void png_level(int level) { m_png_level = std::clamp(level, 0, 9); }
+    int png_level() const { return m_png_level; }
+    unsigned nb_threads() const { return m_nb_threads; }
+
+    static Image_format format(const std::string& path) {
+      const std::size_t dot = path.find_last_of('.');
+      std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+      std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+      if (extension == "qoi") return IMAGE_QOI;
+      if (extension == "ppm") return IMAGE_PPM;
+      if (extension == "pam") return IMAGE_PAM;
+      if (extension == "rgba") return IMAGE_RGBA;
+      return IMAGE_PNG;
+    }
+
+    // Whole image at once, see Image_stream
+    inline bool write(const std::string& path, const unsigned char* rgb, int width, int height) const;
+
+  private:
+    friend class Image_stream;
+
+    // Filter of the smallest sum of absolute differences (None for stored blocks),
+    // up is the previous row (zeros for the first one), scratch holds 5 rows
+    static void filter_row(unsigned char* out, const unsigned char* line, const unsigned char* up,
+                           std::size_t rowSize, unsigned char* scratch, int level) {
+      if (level == 0) {
+        out[0] = 0;
+        std::copy_n(line, rowSize, out + 1);
+        return;
+      }
+
+      unsigned char* none = scratch;
+      unsigned char* sub = none + rowSize;
+      unsigned char* upper = sub + rowSize;
+      unsigned char* average = upper + rowSize;
+      unsigned char* paeth = average + rowSize;
+      for (std::size_t i = 0; i < rowSize; ++i) {
+        const int x = line[i], a = i >= 3 ? line[i - 3] : 0, b = up[i], c = i >= 3 ? up[i - 3] : 0;
+        const int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        none[i] = static_cast<unsigned char>(x);
+        sub[i] = static_cast<unsigned char>(x - a);
+        upper[i] = static_cast<unsigned char>(x - b);
+        average[i] = static_cast<unsigned char>(x - ((a + b) >> 1));
+        paeth[i] = static_cast<unsigned char>(x - (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+      }
+
+      int best = 0;
+      long bestSum = -1;
+      for (int type = 0; type < 5; ++type) {
+        const unsigned char* filtered = scratch + type * rowSize;
+        long sum = 0;
+        for (std::size_t i = 0; i < rowSize; ++i) { sum += std::abs(static_cast<signed char>(filtered[i])); }
+        if (bestSum < 0 || sum < bestSum) {
+          bestSum = sum;
+          best = type;
+        }
+      }
+
+      out[0] = static_cast<unsigned char>(best);
+      std::copy_n(scratch + best * rowSize, rowSize, out + 1);
+    }
+
+    /*********************** DEFLATE ***********************/
+
+    struct Bit_writer {
+      std::vector<unsigned char>& out;
+      std::uint32_t bits = 0;
+      int count = 0;
+
+      void put(std::uint32_t value, int n) {
+        bits |= value << count;
+        count += n;
+        while (count >= 8) {
+          out.push_back(static_cast<unsigned char>(bits));
+          bits >>= 8;
+          count -= 8;
+        }
+      }
+      // Huffman codes are stored from their most significant bit
+      void put_code(std::uint32_t code, int n) {
+        std::uint32_t reversed = 0;
+        for (int i = 0; i < n; ++i) { reversed |= ((code >> i) & 1u) << (n - 1 - i); }
+        put(reversed, n);
+      }
+      void align() {
+        if (count > 0) { out.push_back(static_cast<unsigned char>(bits)); }
+        bits = 0;
+        count = 0;
+      }
+    };
+
+    // Non final blocks ended by an empty stored block (byte aligned), the strips can be concatenated
+    static void deflate(std::vector<unsigned char>& out, const std::vector<unsigned char>& data, int level) {
+      Bit_writer writer{out};
+
+      if (level == 0) {
+        for (std::size_t first = 0; first < data.size(); first += 65535) {
+          const std::size_t n = std::min<std::size_t>(65535, data.size() - first);
+          writer.put(0, 3);
+          writer.align();
+          out.insert(out.end(), {static_cast<unsigned char>(n), static_cast<unsigned char>(n >> 8),
+                                 static_cast<unsigned char>(~n), static_cast<unsigned char>(~n >> 8)});
+          out.insert(out.end(), data.begin() + first, data.begin() + first + n);
+        }
+        return;
+      }
+
+      writer.put(0, 1); // not final
+      writer.put(1, 2); // fixed Huffman codes
+
+      // LZ77 with hash chains, their length grows with the level
+      const int maxChain = 1 << (level - 1);
+      const std::size_t hashSize = 1 << 15, window = 32768;
+      std::vector<std::int32_t> head(hashSize, -1), previous(data.size(), -1);
+      auto hash = [&](std::size_t i) {
+        return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & (hashSize - 1);
+      };
+
+      const std::size_t n = data.size();
+      std::size_t i = 0;
+      while (i < n) {
+        std::size_t bestLength = 0, bestDistance = 0;
+        if (i + 3 <= n) {
+          const std::size_t h = hash(i);
+          std::int32_t candidate = head[h];
+          const std::size_t maxLength = std::min<std::size_t>(258, n - i);
+          for (int chain = 0; candidate >= 0 && i - candidate <= window && chain < maxChain; ++chain) {
+            std::size_t length = 0;
+            while (length < maxLength && data[candidate + length] == data[i + length]) { ++length; }
+            if (length > bestLength) {
+              bestLength = length;
+              bestDistance = i - candidate;
+              if (length == maxLength) break;
+            }
+            candidate = previous[candidate];
+          }
+          previous[i] = head[h];
+          head[h] = static_cast<std::int32_t>(i);
+        }
+
+        if (bestLength < 3) {
+          put_literal(writer, data[i]);
+          ++i;
+          continue;
+        }
+
+        put_match(writer, bestLength, bestDistance);
+        // Positions of the match are hashed, the first one already is
+        for (std::size_t j = i + 1; j < i + bestLength && j + 3 <= n; ++j) {
+          const std::size_t h = hash(j);
+          previous[j] = head[h];
+          head[h] = static_cast<std::int32_t>(j);
+        }
+        i += bestLength;
+      }
+
+      put_literal(writer, 256); // end of block
+      writer.put(0, 3);         // empty stored block
+      writer.align();
+      out.insert(out.end(), {0x00, 0x00, 0xff, 0xff});
+    }
+
+    static void put_literal(Bit_writer& writer, unsigned symbol) {
+      if (symbol < 144) writer.put_code(0x30 + symbol, 8);
+      else if (symbol < 256) writer.put_code(0x190 + symbol - 144, 9);
+      else if (symbol < 280) writer.put_code(symbol - 256, 7);
+      else writer.put_code(0xc0 + symbol - 280, 8);
+    }
+
+    static void put_match(Bit_writer& writer, std::size_t length, std::size_t distance) {
+      static const unsigned short lengthBase[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+      static const unsigned char lengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+      static const unsigned short distanceBase[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                                    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                                    8193, 12289, 16385, 24577};
+      static const unsigned char distanceExtra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+      int l = 28;
+      while (lengthBase[l] > length) { --l; }
+      put_literal(writer, 257 + l);
+      writer.put(static_cast<std::uint32_t>(length - lengthBase[l]), lengthExtra[l]);
+
+      int d = 29;
+      while (distanceBase[d] > distance) { --d; }
+      writer.put_code(d, 5);
+      writer.put(static_cast<std::uint32_t>(distance - distanceBase[d]), distanceExtra[d]);
+    }
+
+    /*********************** CHECKSUMS ***********************/
+
+    static std::uint32_t adler32(std::uint32_t adler, const unsigned char* data, std::size_t size) {
+      std::uint32_t a = adler & 0xffff, b = adler >> 16;
+      while (size > 0) {
+        const std::size_t n = std::min<std::size_t>(size, 5552); // no overflow before the modulo
+        for (std::size_t i = 0; i < n; ++i) {
+          a += data[i];
+          b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += n;
+        size -= n;
+      }
+      return (b << 16) | a;
+    }
+
+    // Adler-32 of the concatenation, adler2 being the checksum of length2 bytes
+    static std::uint32_t adler32_combine(std::uint32_t adler1, std::uint32_t adler2, std::size_t length2) {
+      const std::uint64_t base = 65521;
+      const std::uint64_t a1 = adler1 & 0xffff, b1 = adler1 >> 16;
+      const std::uint64_t a2 = adler2 & 0xffff, b2 = adler2 >> 16;
+      const std::uint64_t a = (a1 + a2 + base - 1) % base;
+      const std::uint64_t b = (b1 + b2 + (length2 % base) * ((a1 + base - 1) % base)) % base;
+      return static_cast<std::uint32_t>((b << 16) | a);
+    }
+
+    static std::uint32_t crc32(const unsigned char* data, std::size_t size) {
+      static const std::vector<std::uint32_t> table = [] {
+        std::vector<std::uint32_t> t(256);
+        for (std::uint32_t n = 0; n < 256; ++n) {
+          std::uint32_t c = n;
+          for (int k = 0; k < 8; ++k) { c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1; }
+          t[n] = c;
+        }
+        return t;
+      }();
+
+      std::uint32_t crc = 0xffffffffu;
+      for (std::size_t i = 0; i < size; ++i) { crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8); }
+      return crc ^ 0xffffffffu;
+    }
+
+    static void put_be32(std::vector<unsigned char>& out, std::uint32_t value) {
+      out.insert(out.end(), {static_cast<unsigned char>(value >> 24), static_cast<unsigned char>(value >> 16),
+                             static_cast<unsigned char>(value >> 8), static_cast<unsigned char>(value)});
+    }
+
+    static void write_chunk(std::ostream& out, const char* type, const unsigned char* data, std::size_t size) {
+      std::vector<unsigned char> chunk;
+      put_be32(chunk, static_cast<std::uint32_t>(size));
+      chunk.insert(chunk.end(), type, type + 4);
+      if (size > 0) { chunk.insert(chunk.end(), data, data + size); }
+      put_be32(chunk, crc32(chunk.data() + 4, size + 4));
+      out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+
+    int m_png_level;
+    unsigned m_nb_threads;
+  };
+
+  /**
+   * Image written by bands of rows, from the top, so that it is never held in memory as a whole
+   * (see Basic_Viewer::make_poster). The PNG strips of a band are compressed in parallel.
+   */
+  class Image_stream {
+  public:
+    explicit Image_stream(const Image_encoder& encoder) : m_encoder(encoder) {}
+
+    bool open(const std::string& path, int width, int height) {
+      m_out.open(path, std::ios::binary);
+      if (!m_out) return false;
+
+      m_format = Image_encoder::format(path);
+      m_width = width;
+      m_height = height;
+      m_rows = 0;
+
+      switch (m_format) {
+        case IMAGE_PNG: {
+          static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+          m_out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+          std::vector<unsigned char> header;
+          Image_encoder::put_be32(header, width);
+          Image_encoder::put_be32(header, height);
+          header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bits, RGB, deflate, adaptive filtering, no interlace
+          Image_encoder::write_chunk(m_out, "IHDR", header.data(), header.size());
+
+          m_last_row.assign(row_size(), 0); // "previous" row of the first one
+          m_adler = 1;
+          break;
+        }
+        case IMAGE_QOI: {
+          std::vector<unsigned char> header = {'q', 'o', 'i', 'f'};
+          Image_encoder::put_be32(header, width);
+          Image_encoder::put_be32(header, height);
+          header.insert(header.end(), {3, 0}); // RGB, sRGB
+          m_out.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+          std::fill(&m_index[0][0], &m_index[0][0] + 64 * 4, 0);
+          std::fill(m_previous, m_previous + 3, 0);
+          m_run = 0;
+          m_pixel = 0;
+          break;
+        }
+        case IMAGE_PPM:
+          m_out << "P6\n" << width << ' ' << height << "\n255\n";
+          break;
+        case IMAGE_PAM:
+          m_out << "P7\nWIDTH " << width << "\nHEIGHT " << height << "\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n";
+          break;
+        case IMAGE_RGBA: {
+          std::vector<unsigned char> header = {'R', 'G', 'B', 'A'};
+          for (std::uint32_t value : {static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height)}) {
+            header.insert(header.end(), {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+                                         static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)});
+          }
+          m_out.write(reinterpret_cast<const char*>(header.data()), header.size());
+          break;
+        }
+      }
+      return static_cast<bool>(m_out);
+    }
+
+    // Next nbRows rows of the image
+    void write_rows(const unsigned char* rgb, int nbRows) {
+      nbRows = std::min(nbRows, m_height - m_rows);
+      if (nbRows <= 0) return;
+
+      switch (m_format) {
+        case IMAGE_PNG:
+          write_png_rows(rgb, nbRows);
+          break;
+        case IMAGE_QOI:
+          write_qoi_rows(rgb, nbRows);
+          break;
+        case IMAGE_RGBA:
+          write_rgba_rows(rgb, nbRows);
+          break;
+        default:
+          m_out.write(reinterpret_cast<const char*>(rgb), row_size() * nbRows);
+      }
+      m_rows += nbRows;
+    }
+
+    // Returns false if the image is incomplete or could not be written
+    bool close() {
+      if (!m_out.is_open()) return false;
+
+      if (m_format == IMAGE_PNG) {
+        // Final empty fixed Huffman block and checksum of the zlib stream
+        std::vector<unsigned char> end = {0x03, 0x00};
+        Image_encoder::put_be32(end, m_adler);
+        Image_encoder::write_chunk(m_out, "IDAT", end.data(), end.size());
+        Image_encoder::write_chunk(m_out, "IEND", nullptr, 0);
+      } else if (m_format == IMAGE_QOI) {
+        static const unsigned char end[] = {0, 0, 0, 0, 0, 0, 0, 1};
+        m_out.write(reinterpret_cast<const char*>(end), sizeof(end));
+      }
+
+      const bool complete = m_rows == m_height && static_cast<bool>(m_out);
+      m_out.close();
+      return complete;
+    }
+
+  private:
+    std::size_t row_size() const { return static_cast<std::size_t>(m_width) * 3; }
+
+    /*********************** PNG ***********************/
+
+    struct Png_strip {
+      std::vector<unsigned char> chunk; // IDAT chunk, with length and CRC
+      std::uint32_t adler = 1;          // of the filtered rows
+      std::size_t length = 0;
+    };
+
+    void write_png_rows(const unsigned char* rgb, int nbRows) {
+      // Strips of at least 16 rows, one or more per thread
+      const int nbStrips = std::max(1, std::min(static_cast<int>(m_encoder.nb_threads()), nbRows / 16));
+      std::vector<Png_strip> strips(nbStrips);
+      auto encode = [&](int s) {
+        encode_strip(strips[s], rgb, nbRows * s / nbStrips, nbRows * (s + 1) / nbStrips, m_rows == 0 && s == 0);
+      };
+
+      std::vector<std::thread> threads;
+      for (int s = 1; s < nbStrips; ++s) { threads.emplace_back(encode, s); }
+      encode(0);
+      for (std::thread& thread : threads) { thread.join(); }
+
+      for (const Png_strip& strip : strips) {
+        m_out.write(reinterpret_cast<const char*>(strip.chunk.data()), strip.chunk.size());
+        m_adler = Image_encoder::adler32_combine(m_adler, strip.adler, strip.length);
+      }
+      std::copy_n(rgb + (nbRows - 1) * row_size(), row_size(), m_last_row.begin());
+    }
+
+    // Rows [firstRow, endRow) of the band rgb
+    void encode_strip(Png_strip& strip, const unsigned char* rgb, int firstRow, int endRow, bool zlibHeader) const {
+      const std::size_t rowSize = row_size();
+
+      // Filtered rows: filter type byte followed by the filtered row
+      std::vector<unsigned char> filtered((rowSize + 1) * (endRow - firstRow));
+      std::vector<unsigned char> scratch(5 * rowSize);
+      for (int row = firstRow; row < endRow; ++row) {
+        const unsigned char* line = rgb + row * rowSize;
+        const unsigned char* up = row > 0 ? line - rowSize : m_last_row.data();
+        Image_encoder::filter_row(&filtered[(row - firstRow) * (rowSize + 1)], line, up, rowSize,
+                                  scratch.data(), m_encoder.png_level());
+      }
+      strip.adler = Image_encoder::adler32(1, filtered.data(), filtered.size());
+      strip.length = filtered.size();
+
+      std::vector<unsigned char>& chunk = strip.chunk;
+      chunk.assign(8, 0); // length and type, written below
+      if (zlibHeader) { chunk.insert(chunk.end(), {0x78, 0x01}); } // deflate, 32K window
+      Image_encoder::deflate(chunk, filtered, m_encoder.png_level());
+
+      const std::size_t length = chunk.size() - 8;
+      for (int i = 0; i < 4; ++i) {
+        chunk[i] = static_cast<unsigned char>(length >> (24 - 8 * i));
+        chunk[4 + i] = "IDAT"[i];
+      }
+      Image_encoder::put_be32(chunk, Image_encoder::crc32(chunk.data() + 4, length + 4));
+    }
+
+    /*********************** QOI / RAW ***********************/
+
+    void write_qoi_rows(const unsigned char* rgb, int nbRows) {
+      std::vector<unsigned char> data;
+      data.reserve(row_size() * nbRows / 2);
+
+      const std::size_t nbPixels = static_cast<std::size_t>(m_width) * m_height;
+      const std::size_t end = m_pixel + static_cast<std::size_t>(m_width) * nbRows;
+      for (const unsigned char* px = rgb; m_pixel < end; ++m_pixel, px += 3) {
+        if (px[0] == m_previous[0] && px[1] == m_previous[1] && px[2] == m_previous[2]) {
+          if (++m_run == 62 || m_pixel + 1 == nbPixels) {
+            data.push_back(static_cast<unsigned char>(0xc0 | (m_run - 1)));
+            m_run = 0;
+          }
+          continue;
+        }
+        if (m_run > 0) {
+          data.push_back(static_cast<unsigned char>(0xc0 | (m_run - 1)));
+          m_run = 0;
+        }
+
+        // Slots of the index are RGBA and start at 0 like in the decoder: an unwritten slot never
+        // matches a pixel, whose alpha is 255
+        const int h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+        if (std::equal(px, px + 3, m_index[h]) && m_index[h][3] == 255) {
+          data.push_back(static_cast<unsigned char>(h));
+        } else {
+          std::copy_n(px, 3, m_index[h]);
+          m_index[h][3] = 255;
+          const int dr = static_cast<signed char>(px[0] - m_previous[0]);
+          const int dg = static_cast<signed char>(px[1] - m_previous[1]);
+          const int db = static_cast<signed char>(px[2] - m_previous[2]);
+          const int drDg = dr - dg, dbDg = db - dg;
+          if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+            data.push_back(static_cast<unsigned char>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+          } else if (dg >= -32 && dg <= 31 && drDg >= -8 && drDg <= 7 && dbDg >= -8 && dbDg <= 7) {
+            data.push_back(static_cast<unsigned char>(0x80 | (dg + 32)));
+            data.push_back(static_cast<unsigned char>((drDg + 8) << 4 | (dbDg + 8)));
+          } else {
+            data.insert(data.end(), {0xfe, px[0], px[1], px[2]});
+          }
+        }
+        std::copy_n(px, 3, m_previous);
+      }
+      m_out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    void write_rgba_rows(const unsigned char* rgb, int nbRows) {
+      std::vector<unsigned char> row(static_cast<std::size_t>(m_width) * 4);
+      for (int y = 0; y < nbRows; ++y) {
+        const unsigned char* line = rgb + y * row_size();
+        for (int x = 0; x < m_width; ++x) {
+          std::copy_n(line + 3 * x, 3, &row[4 * x]);
+          row[4 * x + 3] = 255;
+        }
+        m_out.write(reinterpret_cast<const char*>(row.data()), row.size());
+      }
+    }
+
+    Image_encoder m_encoder;
+    Image_format m_format = IMAGE_PNG;
+    std::ofstream m_out;
+    int m_width = 0;
+    int m_height = 0;
+    int m_rows = 0; // written rows
+
+    std::vector<unsigned char> m_last_row; // PNG: filters of the next row refer to it
+    std::uint32_t m_adler = 1;             // PNG: checksum of the zlib stream so far
+
+    unsigned char m_index[64][4] = {};     // QOI state, kept between the bands
+    unsigned char m_previous[3] = {};
+    int m_run = 0;
+    std::size_t m_pixel = 0;
+  };
+
+  bool Image_encoder::write(const std::string& path, const unsigned char* rgb, int width, int height) const {
+    Image_stream stream(*this);
+    if (!stream.open(path, width, height)) return false;
+
+    stream.write_rows(rgb, height);
+    return stream.close();
+  }
+}
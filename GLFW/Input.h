@@ -64,6 +64,14 @@ public:
 
   double get_scroll_delta_y() { return scrollDeltaY; }
 
+  // true while a hold action runs (between start_action and end_action)
+  bool has_started_actions() const {
+    for (const auto& pair : started_actions) {
+      if (pair.second) return true;
+    }
+    return false;
+  }
+
   static std::string get_key_string(KeyData keys);
 
   void add_action(int key, bool hold, ActionEnum action);
@@ -86,7 +94,7 @@ protected:
   void on_cursor_event(double xpos, double ypos);
   void on_mouse_btn_event(int button, int action, int mods);
   void on_scroll_event(double xoffset, double yoffset);
-  void handle_events();
+  void handle_events(double waitTimeout = 0);
 
   virtual void start_action(ActionEnum action) = 0;
   virtual void action_event(ActionEnum action) = 0;
@@ -278,12 +286,17 @@ void Input::on_mouse_btn_event(int btn, int action, int mods) {
   }
 }
 
-void Input::handle_events(){
+// waitTimeout > 0: sleeps until an event arrives or for at most waitTimeout seconds
+void Input::handle_events(double waitTimeout){
   pressed_keys.clear();
   consumed_keys.clear();
   activated_actions.clear();
 
-  glfwPollEvents();
+  if (waitTimeout > 0) {
+    glfwWaitEventsTimeout(waitTimeout);
+  } else {
+    glfwPollEvents();
+  }
 
   for (Action act : key_actions){
     KeyData k = act.keys;
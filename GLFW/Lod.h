@@ -0,0 +1,488 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <eigen3/Eigen/LU>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Bv_Settings.h"
+#include "Chunks.h"
+
+namespace CGAL::GLFW {
+  // One version of a chunk, a range of the index buffer of the Lod_mesh
+  struct Lod_level {
+    std::size_t first_index;
+    std::size_t nb_indices;
+    std::size_t base_vertex; // added to the indices of the level
+    float error;             // object space distance bound to the full resolution chunk
+  };
+
+  struct Lod_chunk {
+    Eigen::AlignedBox3f box;
+    std::vector<Lod_level> levels; // levels[0] is the full resolution, then coarser and coarser
+  };
+
+  namespace internal {
+    /**
+     * Edge collapse simplification driven by quadric error metrics (Garland & Heckbert).
+     * Vertices on a border of the input (mesh border or chunk border) and on non manifold
+     * edges are locked, so independent chunks stay connected at every level.
+     * Collapses changing the topology or flipping a triangle are rejected.
+     */
+    class Lod_simplifier {
+    public:
+      Lod_simplifier(const std::vector<Eigen::Vector3f>& points, const std::vector<std::uint32_t>& triangles) :
+        m_points(points.size()),
+        m_quadrics(points.size(), Eigen::Matrix4d::Zero()),
+        m_vertex_triangles(points.size()),
+        m_locked(points.size(), 0),
+        m_stamps(points.size(), 0),
+        m_triangles(triangles),
+        m_alive(triangles.size() / 3, 1),
+        m_nb_triangles(triangles.size() / 3)
+      {
+        for (std::size_t v = 0; v < points.size(); ++v) {
+          m_points[v] = points[v].cast<double>();
+        }
+
+        std::unordered_map<std::uint64_t, int> edges;
+        for (std::uint32_t t = 0; t < m_nb_triangles; ++t) {
+          const std::uint32_t* tri = &m_triangles[3 * t];
+          Eigen::Vector3d n = (m_points[tri[1]] - m_points[tri[0]]).cross(m_points[tri[2]] - m_points[tri[0]]);
+          if (n.norm() > 0) {
+            n.normalize();
+            const Eigen::Vector4d plane(n.x(), n.y(), n.z(), -n.dot(m_points[tri[0]]));
+            const Eigen::Matrix4d q = plane * plane.transpose();
+            for (int k = 0; k < 3; ++k) { m_quadrics[tri[k]] += q; }
+          }
+
+          for (int k = 0; k < 3; ++k) {
+            m_vertex_triangles[tri[k]].push_back(t);
+            ++edges[edge_key(tri[k], tri[(k + 1) % 3])];
+          }
+        }
+
+        // An edge not shared by exactly two triangles is on a border
+        for (const auto& edge : edges) {
+          if (edge.second != 2) {
+            m_locked[edge.first >> 32] = 1;
+            m_locked[edge.first & 0xffffffffu] = 1;
+          }
+        }
+
+        for (const auto& edge : edges) {
+          push_candidate(static_cast<std::uint32_t>(edge.first >> 32), static_cast<std::uint32_t>(edge.first & 0xffffffffu));
+        }
+      }
+
+      std::size_t number_of_triangles() const { return m_nb_triangles; }
+      float error() const { return static_cast<float>(m_error); }
+      bool locked(std::uint32_t v) const { return m_locked[v] != 0; }
+
+      // Collapses edges until at most target triangles are left or the next collapse
+      // would move the surface further than maxError.
+      void simplify(std::size_t target, float maxError) {
+        const double maxCost = double(maxError) * double(maxError);
+
+        while (m_nb_triangles > target && !m_heap.empty()) {
+          const Candidate c = m_heap.top();
+          if (!is_valid(c)) {
+            m_heap.pop();
+            continue;
+          }
+
+          // the cheapest collapse is already beyond the bound
+          if (c.cost > maxCost) break;
+
+          m_heap.pop();
+          if (collapse(c)) {
+            m_error = std::max(m_error, std::sqrt(c.cost));
+          }
+        }
+      }
+
+      // f(t, a, b, c) for each remaining triangle, t is its index in the input triangles
+      void for_each_triangle(const std::function<void(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t)>& f) const {
+        for (std::uint32_t t = 0; t < m_alive.size(); ++t) {
+          if (m_alive[t]) { f(t, m_triangles[3 * t], m_triangles[3 * t + 1], m_triangles[3 * t + 2]); }
+        }
+      }
+
+      Eigen::Vector3f point(std::uint32_t v) const { return m_points[v].cast<float>(); }
+
+    private:
+      struct Candidate {
+        double cost;
+        std::uint32_t u, v;               // u is kept, v is removed
+        std::uint32_t stamp_u, stamp_v;
+        Eigen::Vector3d p;
+
+        bool operator>(const Candidate& other) const { return cost > other.cost; }
+      };
+
+      static std::uint64_t edge_key(std::uint32_t a, std::uint32_t b) {
+        if (a > b) std::swap(a, b);
+        return (std::uint64_t(a) << 32) | b;
+      }
+
+      static double cost_at(const Eigen::Matrix4d& q, const Eigen::Vector3d& p) {
+        const Eigen::Vector4d h(p.x(), p.y(), p.z(), 1.0);
+        return std::max(0.0, h.dot(q * h));
+      }
+
+      bool is_valid(const Candidate& c) const {
+        return !m_vertex_triangles[c.u].empty() && !m_vertex_triangles[c.v].empty() &&
+               m_stamps[c.u] == c.stamp_u && m_stamps[c.v] == c.stamp_v;
+      }
+
+      void push_candidate(std::uint32_t u, std::uint32_t v) {
+        if (m_locked[u] && m_locked[v]) return;
+        if (m_locked[v]) std::swap(u, v); // a locked vertex is kept at its position
+
+        const Eigen::Matrix4d q = m_quadrics[u] + m_quadrics[v];
+        const Eigen::Vector3d& pu = m_points[u];
+        const Eigen::Vector3d& pv = m_points[v];
+
+        Candidate c {0, u, v, m_stamps[u], m_stamps[v], pu};
+        if (!m_locked[u]) {
+          // Minimum of the quadric, unless it is singular or too far from the edge
+          Eigen::FullPivLU<Eigen::Matrix3d> lu(q.topLeftCorner<3, 3>());
+          const Eigen::Vector3d mid = 0.5 * (pu + pv);
+          bool optimal = false;
+          if (lu.isInvertible()) {
+            const Eigen::Vector3d p = lu.solve(-q.topRightCorner<3, 1>());
+            if ((p - mid).norm() <= (pu - pv).norm()) {
+              c.p = p;
+              optimal = true;
+            }
+          }
+
+          if (!optimal) {
+            for (const Eigen::Vector3d& p : {pv, mid}) {
+              if (cost_at(q, p) < cost_at(q, c.p)) c.p = p;
+            }
+          }
+        }
+
+        c.cost = cost_at(q, c.p);
+        m_heap.push(c);
+      }
+
+      // Live triangles of v, dead ones are removed from its list
+      std::vector<std::uint32_t>& triangles_of(std::uint32_t v) {
+        auto& list = m_vertex_triangles[v];
+        list.erase(std::remove_if(list.begin(), list.end(), [this](std::uint32_t t) { return !m_alive[t]; }), list.end());
+        return list;
+      }
+
+      bool has_vertex(std::uint32_t t, std::uint32_t v) const {
+        return m_triangles[3 * t] == v || m_triangles[3 * t + 1] == v || m_triangles[3 * t + 2] == v;
+      }
+
+      std::vector<std::uint32_t> neighbors(std::uint32_t v) {
+        std::vector<std::uint32_t> result;
+        for (std::uint32_t t : triangles_of(v)) {
+          for (int k = 0; k < 3; ++k) {
+            if (m_triangles[3 * t + k] != v) result.push_back(m_triangles[3 * t + k]);
+          }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+      }
+
+      // The triangles around the moved vertices must keep their orientation
+      bool flips(std::uint32_t moved, std::uint32_t other, const Eigen::Vector3d& p) {
+        for (std::uint32_t t : triangles_of(moved)) {
+          if (has_vertex(t, other)) continue;
+
+          Eigen::Vector3d before[3], after[3];
+          for (int k = 0; k < 3; ++k) {
+            const std::uint32_t w = m_triangles[3 * t + k];
+            before[k] = m_points[w];
+            after[k] = w == moved ? p : m_points[w];
+          }
+
+          const Eigen::Vector3d n0 = (before[1] - before[0]).cross(before[2] - before[0]);
+          const Eigen::Vector3d n1 = (after[1] - after[0]).cross(after[2] - after[0]);
+          if (n0.dot(n1) <= 0) return true;
+        }
+        return false;
+      }
+
+      bool collapse(const Candidate& c) {
+        const std::uint32_t u = c.u, v = c.v;
+
+        // Link condition: u and v share exactly the vertices opposite to the edge
+        std::size_t nbShared = 0;
+        for (std::uint32_t t : triangles_of(u)) {
+          if (has_vertex(t, v)) ++nbShared;
+        }
+
+        const std::vector<std::uint32_t> nu = neighbors(u), nv = neighbors(v);
+        std::vector<std::uint32_t> common;
+        std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(), std::back_inserter(common));
+        if (common.size() != nbShared) return false;
+
+        if (flips(u, v, c.p) || flips(v, u, c.p)) return false;
+
+        for (std::uint32_t t : triangles_of(v)) {
+          if (has_vertex(t, u)) {
+            m_alive[t] = 0;
+            --m_nb_triangles;
+            continue;
+          }
+
+          for (int k = 0; k < 3; ++k) {
+            if (m_triangles[3 * t + k] == v) m_triangles[3 * t + k] = u;
+          }
+          m_vertex_triangles[u].push_back(t);
+        }
+
+        m_vertex_triangles[v].clear();
+        m_vertex_triangles[v].shrink_to_fit();
+        m_points[u] = c.p;
+        m_quadrics[u] += m_quadrics[v];
+        ++m_stamps[u];
+
+        for (std::uint32_t w : neighbors(u)) {
+          push_candidate(u, w);
+        }
+        return true;
+      }
+
+      std::vector<Eigen::Vector3d> m_points;
+      std::vector<Eigen::Matrix4d> m_quadrics;
+      std::vector<std::vector<std::uint32_t>> m_vertex_triangles; // empty for removed vertices
+      std::vector<char> m_locked;
+      std::vector<std::uint32_t> m_stamps; // incremented when a vertex moves, outdates its candidates
+
+      std::vector<std::uint32_t> m_triangles;
+      std::vector<char> m_alive;
+      std::size_t m_nb_triangles;
+
+      std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> m_heap;
+      double m_error = 0;
+    };
+  }
+
+  /**
+   * Level of detail hierarchy of a triangle mesh. The mesh is split in spatial chunks,
+   * each chunk is simplified several times by edge collapses (LOD_LEVELS, each level keeping
+   * LOD_REDUCTION of the triangles of the previous one, without moving the surface further than
+   * LOD_MAX_ERROR times the chunk diagonal). Chunk borders are kept, so levels can be selected
+   * independently for each chunk. All the levels share one vertex array (position, smooth normal
+   * and color per vertex) and one index array.
+   */
+  class Lod_mesh {
+  public:
+    // Adds the area weighted normals of triangles to the vertex normals (3 floats per vertex of points)
+    static void add_normals(const std::vector<float>& points, const std::vector<std::uint32_t>& triangles,
+                            std::vector<float>& normals) {
+      normals.resize(points.size(), 0.f);
+      for (std::size_t t = 0; t < triangles.size(); t += 3) {
+        const Eigen::Map<const Eigen::Vector3f> a(points.data() + 3 * triangles[t]);
+        const Eigen::Map<const Eigen::Vector3f> b(points.data() + 3 * triangles[t + 1]);
+        const Eigen::Map<const Eigen::Vector3f> c(points.data() + 3 * triangles[t + 2]);
+        const Eigen::Vector3f n = (b - a).cross(c - a);
+        for (int k = 0; k < 3; ++k) {
+          Eigen::Map<Eigen::Vector3f>(normals.data() + 3 * triangles[t + k]) += n;
+        }
+      }
+    }
+
+    // points: 3 floats per vertex, triangles: 3 vertex indices per triangle,
+    // colors: 3 floats per triangle, empty for mono colored triangles,
+    // normals: 3 floats per vertex (see add_normals), computed from triangles if empty. They are the
+    // normals of the chunk border vertices, so that the shading of neighbor chunks matches.
+    void add_triangles(const std::vector<float>& points, const std::vector<std::uint32_t>& triangles,
+                       const std::vector<float>& colors = {}, const std::vector<float>& normals = {}) {
+      const bool colored = !colors.empty();
+      const std::size_t nbTriangles = triangles.size() / 3;
+
+      std::vector<float> ownNormals;
+      if (normals.empty()) { add_normals(points, triangles, ownNormals); }
+      const std::vector<float>& vertexNormals = normals.empty() ? ownNormals : normals;
+
+      Chunk_partition partition;
+      partition.build(nbTriangles, 3, LOD_CHUNK_SIZE, [&](std::size_t t, int k) {
+        const float* p = points.data() + 3 * triangles[3 * t + k];
+        return Eigen::Vector3f(p[0], p[1], p[2]);
+      });
+
+      // Chunks are simplified in parallel, then appended in order
+      const std::vector<Chunk>& chunks = partition.chunks();
+      std::vector<Chunk_data> results(chunks.size());
+      std::atomic<std::size_t> next {0};
+
+      auto worker = [&]() {
+        for (std::size_t c = next++; c < chunks.size(); c = next++) {
+          const std::uint32_t* order = partition.primitive_order().data() + chunks[c].first / 3;
+          results[c] = build_chunk(points, triangles, colors, vertexNormals, order, chunks[c].count / 3);
+          results[c].box = chunks[c].box;
+        }
+      };
+
+      const std::size_t nbThreads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), chunks.size());
+      std::vector<std::thread> threads;
+      for (std::size_t i = 1; i < nbThreads; ++i) { threads.emplace_back(worker); }
+      worker();
+      for (std::thread& thread : threads) { thread.join(); }
+
+      for (Chunk_data& result : results) {
+        append(result, colored ? m_colored_chunks : m_mono_chunks);
+      }
+    }
+
+    void clear() {
+      m_positions.clear();
+      m_normals.clear();
+      m_colors.clear();
+      m_indices.clear();
+      m_mono_chunks.clear();
+      m_colored_chunks.clear();
+    }
+
+    bool empty() const { return m_mono_chunks.empty() && m_colored_chunks.empty(); }
+
+    // 3 floats per vertex
+    const std::vector<float>& positions() const { return m_positions; }
+    const std::vector<float>& normals() const { return m_normals; }
+    const std::vector<float>& colors() const { return m_colors; }
+    const std::vector<std::uint32_t>& indices() const { return m_indices; }
+
+    const std::vector<Lod_chunk>& mono_chunks() const { return m_mono_chunks; }
+    const std::vector<Lod_chunk>& colored_chunks() const { return m_colored_chunks; }
+
+  private:
+    struct Level_data {
+      std::vector<float> positions, normals, colors;
+      std::vector<std::uint32_t> indices;
+      float error;
+    };
+
+    struct Chunk_data {
+      Eigen::AlignedBox3f box;
+      std::vector<Level_data> levels;
+    };
+
+    static Chunk_data build_chunk(const std::vector<float>& points, const std::vector<std::uint32_t>& triangles,
+                                  const std::vector<float>& colors, const std::vector<float>& normals,
+                                  const std::uint32_t* order, std::size_t nbTriangles) {
+      // Local copy of the chunk
+      std::unordered_map<std::uint32_t, std::uint32_t> local;
+      std::vector<Eigen::Vector3f> localPoints, localNormals;
+      std::vector<std::uint32_t> localTriangles(3 * nbTriangles);
+      std::vector<std::uint32_t> localColors(nbTriangles, 0);
+
+      for (std::size_t t = 0; t < nbTriangles; ++t) {
+        for (int k = 0; k < 3; ++k) {
+          const std::uint32_t v = triangles[3 * order[t] + k];
+          auto inserted = local.emplace(v, static_cast<std::uint32_t>(localPoints.size()));
+          if (inserted.second) {
+            localPoints.emplace_back(points[3 * v], points[3 * v + 1], points[3 * v + 2]);
+            localNormals.emplace_back(normals[3 * v], normals[3 * v + 1], normals[3 * v + 2]);
+          }
+          localTriangles[3 * t + k] = inserted.first->second;
+        }
+
+        if (!colors.empty()) {
+          const float* c = colors.data() + 3 * order[t];
+          for (int k = 0; k < 3; ++k) {
+            localColors[t] |= std::uint32_t(std::round(std::clamp(c[k], 0.f, 1.f) * 255.f)) << (8 * k);
+          }
+        }
+      }
+
+      Chunk_data result;
+      internal::Lod_simplifier simplifier(localPoints, localTriangles);
+      result.levels.push_back(extract_level(simplifier, localColors, localNormals));
+
+      Eigen::AlignedBox3f box;
+      for (const Eigen::Vector3f& p : localPoints) { box.extend(p); }
+      const float maxError = LOD_MAX_ERROR * box.diagonal().norm();
+
+      for (int l = 1; l < LOD_LEVELS; ++l) {
+        const std::size_t before = simplifier.number_of_triangles();
+        simplifier.simplify(static_cast<std::size_t>(before * LOD_REDUCTION), maxError);
+
+        // Not worth a level (locked borders, error bound reached)
+        if (simplifier.number_of_triangles() > 0.9 * before) break;
+
+        result.levels.push_back(extract_level(simplifier, localColors, localNormals));
+      }
+
+      return result;
+    }
+
+    // Vertices are duplicated where the color of their triangles differ. Locked vertices (borders) keep
+    // their normal in lockedNormals, the other ones get the normal of their triangles in the level.
+    static Level_data extract_level(const internal::Lod_simplifier& simplifier, const std::vector<std::uint32_t>& colors,
+                                    const std::vector<Eigen::Vector3f>& lockedNormals) {
+      Level_data level;
+      level.error = simplifier.error();
+
+      std::unordered_map<std::uint64_t, std::uint32_t> vertices;
+      simplifier.for_each_triangle([&](std::uint32_t t, std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+        const Eigen::Vector3f pa = simplifier.point(a), pb = simplifier.point(b), pc = simplifier.point(c);
+        const Eigen::Vector3f n = (pb - pa).cross(pc - pa); // area weighted
+
+        for (std::uint32_t v : {a, b, c}) {
+          const std::uint64_t key = (std::uint64_t(v) << 32) | colors[t];
+          auto inserted = vertices.emplace(key, static_cast<std::uint32_t>(level.positions.size() / 3));
+          if (inserted.second) {
+            const Eigen::Vector3f p = simplifier.point(v);
+            level.positions.insert(level.positions.end(), {p.x(), p.y(), p.z()});
+            level.normals.insert(level.normals.end(), {0.f, 0.f, 0.f});
+            for (int k = 0; k < 3; ++k) {
+              level.colors.push_back(float((colors[t] >> (8 * k)) & 0xff) / 255.f);
+            }
+          }
+
+          const std::uint32_t i = inserted.first->second;
+          for (int k = 0; k < 3; ++k) { level.normals[3 * i + k] += n[k]; }
+          level.indices.push_back(i);
+        }
+      });
+
+      for (const auto& vertex : vertices) {
+        const std::uint32_t v = static_cast<std::uint32_t>(vertex.first >> 32);
+        Eigen::Map<Eigen::Vector3f> n(level.normals.data() + 3 * vertex.second);
+        if (simplifier.locked(v)) n = lockedNormals[v];
+        if (n.norm() > 0) n.normalize();
+      }
+
+      return level;
+    }
+
+    void append(Chunk_data& data, std::vector<Lod_chunk>& chunks) {
+      Lod_chunk chunk {data.box, {}};
+      for (Level_data& level : data.levels) {
+        chunk.levels.push_back({m_indices.size(), level.indices.size(), m_positions.size() / 3, level.error});
+
+        m_positions.insert(m_positions.end(), level.positions.begin(), level.positions.end());
+        m_normals.insert(m_normals.end(), level.normals.begin(), level.normals.end());
+        m_colors.insert(m_colors.end(), level.colors.begin(), level.colors.end());
+        m_indices.insert(m_indices.end(), level.indices.begin(), level.indices.end());
+        level = Level_data();
+      }
+      chunks.push_back(std::move(chunk));
+    }
+
+    std::vector<float> m_positions;
+    std::vector<float> m_normals;
+    std::vector<float> m_colors;
+    std::vector<std::uint32_t> m_indices;
+
+    std::vector<Lod_chunk> m_mono_chunks;
+    std::vector<Lod_chunk> m_colored_chunks;
+  };
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+#include "Bv_Settings.h"
+
+#if OFFSCREEN_CONTEXT == OFFSCREEN_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace CGAL::GLFW {
+  /**
+   * Multisampled color and depth renderbuffers, resolved into a single sample framebuffer
+   * before the pixels are read back.
+   */
+  class Offscreen_framebuffer {
+  public:
+    // (Re)allocates the attachments when the size or the number of samples changes.
+    // Returns false if the framebuffer is not complete.
+    bool resize(int width, int height, int samples) {
+      GLint maxSamples = 0;
+      glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+      samples = std::min(samples, static_cast<int>(maxSamples));
+
+      if (m_fbo != 0 && width == m_width && height == m_height && samples == m_samples) return true;
+
+      destroy();
+      m_width = width;
+      m_height = height;
+      m_samples = samples;
+
+      glGenFramebuffers(1, &m_fbo);
+      glGenRenderbuffers(1, &m_color);
+      glGenRenderbuffers(1, &m_depth);
+      glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+      glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+
+      glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+      bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+      // Resolve target
+      glGenFramebuffers(1, &m_resolve_fbo);
+      glGenRenderbuffers(1, &m_resolve_color);
+      glBindFramebuffer(GL_FRAMEBUFFER, m_resolve_fbo);
+      glBindRenderbuffer(GL_RENDERBUFFER, m_resolve_color);
+      glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_resolve_color);
+      complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+      glBindRenderbuffer(GL_RENDERBUFFER, 0);
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      return complete;
+    }
+
+    void destroy() {
+      if (m_fbo == 0) return;
+
+      glDeleteFramebuffers(1, &m_fbo);
+      glDeleteFramebuffers(1, &m_resolve_fbo);
+      GLuint renderbuffers[] = {m_color, m_depth, m_resolve_color};
+      glDeleteRenderbuffers(3, renderbuffers);
+      m_fbo = m_color = m_depth = m_resolve_fbo = m_resolve_color = 0;
+    }
+
+    // Draw target of the next frames
+    void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, m_fbo); }
+
+    // Resolves the samples, the resolved color is left bound as the read framebuffer
+    void resolve() const {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolve_fbo);
+      glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, m_resolve_fbo);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+  private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_samples = 0;
+
+    GLuint m_fbo = 0;
+    GLuint m_color = 0;
+    GLuint m_depth = 0;
+    GLuint m_resolve_fbo = 0;
+    GLuint m_resolve_color = 0;
+  };
+
+  /**
+   * OpenGL 4.3 core context without visible window, selected by OFFSCREEN_CONTEXT
+   * (see Bv_Settings.h). Everything is drawn in an Offscreen_framebuffer.
+   */
+  class Offscreen_context {
+  public:
+    // Creates the context, makes it current and loads the OpenGL functions
+    bool create(int width, int height) {
+#if OFFSCREEN_CONTEXT == OFFSCREEN_EGL
+      // Surfaceless Mesa platform when available (no display, no GPU needed with llvmpipe)
+      auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+      m_display = EGL_NO_DISPLAY;
+      if (getPlatformDisplay != nullptr) {
+        m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+      }
+      if (m_display == EGL_NO_DISPLAY) {
+        m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+      }
+      if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, nullptr, nullptr)) return false;
+
+      const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+      };
+      EGLConfig config;
+      EGLint nbConfigs = 0;
+      if (!eglChooseConfig(m_display, configAttributes, &config, 1, &nbConfigs) || nbConfigs == 0) return false;
+
+      const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+      };
+      eglBindAPI(EGL_OPENGL_API);
+      m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+      if (m_context == EGL_NO_CONTEXT) return false;
+
+      // EGL_KHR_surfaceless_context: no surface, the default framebuffer is never used
+      if (!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) return false;
+      return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress));
+#else
+      if (!glfwInit()) return false;
+
+      glfwDefaultWindowHints();
+      glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+      glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if OFFSCREEN_CONTEXT == OFFSCREEN_OSMESA
+      glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+
+      m_window = glfwCreateWindow(width, height, "", nullptr, nullptr);
+      if (m_window == nullptr) return false;
+
+      glfwMakeContextCurrent(m_window);
+      return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+#endif
+    }
+
+    void destroy() {
+#if OFFSCREEN_CONTEXT == OFFSCREEN_EGL
+      if (m_display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_context != EGL_NO_CONTEXT) { eglDestroyContext(m_display, m_context); }
+        eglTerminate(m_display);
+      }
+      m_display = EGL_NO_DISPLAY;
+      m_context = EGL_NO_CONTEXT;
+#else
+      if (m_window != nullptr) { glfwDestroyWindow(m_window); }
+      m_window = nullptr;
+      glfwTerminate();
+#endif
+    }
+
+    // Hidden window of the GLFW contexts, nullptr with EGL
+    GLFWwindow* window() const { return m_window; }
+
+  private:
+    GLFWwindow* m_window = nullptr;
+#if OFFSCREEN_CONTEXT == OFFSCREEN_EGL
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+#endif
+  };
+}
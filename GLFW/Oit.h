@@ -0,0 +1,175 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+
+#include "Shader.h"
+
+namespace CGAL::GLFW {
+  /**
+   * Weighted blended order independent transparency (McGuire and Bavoil, JCGT 2013).
+   * The whole frame is drawn in this multisampled framebuffer: the opaque surfaces in its color
+   * and depth attachments, then the transparent ones, in any order, accumulate the weighted
+   * premultiplied colors (RGBA16F) and the product of their 1 - alpha (revealage, R8), tested
+   * against the opaque depth without writing it. The composite pass blends the weighted average
+   * color over the opaque one, and the frame is finally drawn in its target framebuffer.
+   *
+   * Fragment outputs: location 0 the opaque color, 1 the accumulation, 2 the revealage.
+   */
+  class Oit_framebuffer {
+  public:
+    // (Re)allocates the attachments when the size or the number of samples changes.
+    // Returns false if the framebuffer is not complete.
+    bool resize(int width, int height, int samples) {
+      GLint maxSamples = 0, maxTextureSamples = 0;
+      glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+      glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &maxTextureSamples);
+      samples = std::clamp(samples, 1, static_cast<int>(std::min(maxSamples, maxTextureSamples)));
+
+      if (m_fbo != 0 && width == m_width && height == m_height && samples == m_samples) return m_complete;
+
+      destroy();
+      m_width = width;
+      m_height = height;
+      m_samples = samples;
+
+      glGenFramebuffers(1, &m_fbo);
+      glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+      GLuint renderbuffers[2];
+      glGenRenderbuffers(2, renderbuffers);
+      m_color = renderbuffers[0];
+      m_depth = renderbuffers[1];
+      glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+      glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+      glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+      // Sampled by the composite pass, sample per sample
+      GLuint textures[2];
+      glGenTextures(2, textures);
+      m_accum = textures[0];
+      m_revealage = textures[1];
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_accum);
+      glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGBA16F, width, height, GL_TRUE);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D_MULTISAMPLE, m_accum, 0);
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_revealage);
+      glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_R8, width, height, GL_TRUE);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D_MULTISAMPLE, m_revealage, 0);
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+      m_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+      // Resolved frame, drawn in the target framebuffer (whatever its format and number of samples)
+      glGenFramebuffers(1, &m_resolve_fbo);
+      glGenTextures(1, &m_resolve_color);
+      glBindFramebuffer(GL_FRAMEBUFFER, m_resolve_fbo);
+      glBindTexture(GL_TEXTURE_2D, m_resolve_color);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_resolve_color, 0);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      m_complete = m_complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+      glGenVertexArrays(1, &m_vao); // full screen triangles, no attribute
+
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      return m_complete;
+    }
+
+    void destroy() {
+      if (m_fbo == 0) return;
+
+      GLuint framebuffers[] = {m_fbo, m_resolve_fbo};
+      GLuint renderbuffers[] = {m_color, m_depth};
+      GLuint textures[] = {m_accum, m_revealage, m_resolve_color};
+      glDeleteFramebuffers(2, framebuffers);
+      glDeleteRenderbuffers(2, renderbuffers);
+      glDeleteTextures(3, textures);
+      glDeleteVertexArrays(1, &m_vao);
+      m_fbo = m_resolve_fbo = m_color = m_depth = m_accum = m_revealage = m_resolve_color = m_vao = 0;
+    }
+
+    // The next draws (opaque) go to this framebuffer, target receives the frame in end()
+    void begin(GLint target) {
+      m_target = target;
+      glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+      set_draw_buffers(GL_COLOR_ATTACHMENT0, GL_NONE, GL_NONE);
+    }
+
+    // The next draws are transparent: accumulated in any order, depth tested but not written
+    void begin_transparency() {
+      static const GLfloat zeros[] = {0, 0, 0, 0};
+      static const GLfloat ones[] = {1, 1, 1, 1};
+      set_draw_buffers(GL_NONE, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2);
+      glClearBufferfv(GL_COLOR, 1, zeros);
+      glClearBufferfv(GL_COLOR, 2, ones);
+
+      glDepthMask(GL_FALSE);
+      glEnable(GL_BLEND);
+      glBlendFunci(1, GL_ONE, GL_ONE);
+      glBlendFunci(2, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    }
+
+    // Blends the transparent surfaces over the opaque ones, the next draws are opaque
+    void composite(Shader& shader) {
+      set_draw_buffers(GL_COLOR_ATTACHMENT0, GL_NONE, GL_NONE);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glDisable(GL_DEPTH_TEST);
+
+      shader.use();
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_accum);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_revealage);
+      glBindVertexArray(m_vao);
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+
+      glActiveTexture(GL_TEXTURE0);
+      glDisable(GL_BLEND);
+      glEnable(GL_DEPTH_TEST);
+      glDepthMask(GL_TRUE);
+    }
+
+    // Resolves the frame and draws it in the target framebuffer with the copy shader
+    void end(Shader& copy) {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolve_fbo);
+      glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+      glBindFramebuffer(GL_FRAMEBUFFER, m_target);
+      glDisable(GL_DEPTH_TEST);
+      copy.use();
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, m_resolve_color);
+      glBindVertexArray(m_vao);
+      glDrawArrays(GL_TRIANGLES, 0, 3);
+      glEnable(GL_DEPTH_TEST);
+    }
+
+  private:
+    static void set_draw_buffers(GLenum b0, GLenum b1, GLenum b2) {
+      const GLenum buffers[] = {b0, b1, b2};
+      glDrawBuffers(3, buffers);
+    }
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_samples = 0;
+    bool m_complete = false;
+    GLint m_target = 0;
+
+    GLuint m_fbo = 0;
+    GLuint m_color = 0;
+    GLuint m_depth = 0;
+    GLuint m_accum = 0;
+    GLuint m_revealage = 0;
+    GLuint m_resolve_fbo = 0;
+    GLuint m_resolve_color = 0;
+    GLuint m_vao = 0;
+  };
+}
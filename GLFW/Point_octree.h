@@ -0,0 +1,153 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+#include "Bv_Settings.h"
+
+namespace CGAL::GLFW {
+  struct Point_octree_node {
+    Eigen::AlignedBox3f box;            // cube of the node
+    std::size_t first;                  // points of the node in the reordered array
+    std::size_t count;
+    float spacing;                      // minimal distance between the points of the node
+    int depth;
+    std::array<std::int32_t, 8> children; // -1 for empty octants
+  };
+
+  /**
+   * Nested octree (as in Potree): each node keeps a subsample of the points of its cube,
+   * at most one point per cell of a POINT_OCTREE_GRID^3 grid, and the other points go down
+   * to its children. Drawing a node and some of its descendants draws a denser and denser
+   * sample of the cloud. Points are reordered depth first: the points of a node, then the
+   * subtrees of its children, so each node is a contiguous range.
+   */
+  class Point_octree {
+  public:
+    // positions: 3 floats per point
+    void build(const std::vector<float>& positions) {
+      clear();
+      m_positions = positions.data();
+
+      const std::size_t nbPoints = positions.size() / 3;
+      if (nbPoints == 0) return;
+
+      m_order.resize(nbPoints);
+      Eigen::AlignedBox3f box;
+      for (std::size_t i = 0; i < nbPoints; ++i) {
+        m_order[i] = static_cast<std::uint32_t>(i);
+        box.extend(point(i));
+      }
+
+      // Cubic root
+      const Eigen::Vector3f center = box.center();
+      const float halfSize = std::max(0.5f * box.sizes().maxCoeff(), std::numeric_limits<float>::min());
+      const Eigen::AlignedBox3f cube(center - Eigen::Vector3f::Constant(halfSize), center + Eigen::Vector3f::Constant(halfSize));
+
+      m_buffer.resize(nbPoints);
+      build_node(0, nbPoints, cube, 0);
+      m_buffer.clear();
+      m_buffer.shrink_to_fit();
+      m_positions = nullptr;
+
+      m_inverse_order.resize(nbPoints);
+      for (std::size_t i = 0; i < nbPoints; ++i) {
+        m_inverse_order[m_order[i]] = static_cast<std::uint32_t>(i);
+      }
+    }
+
+    void clear() {
+      m_order.clear();
+      m_inverse_order.clear();
+      m_nodes.clear();
+    }
+
+    bool empty() const { return m_nodes.empty(); }
+
+    // new point index -> point index in the original array
+    const std::vector<std::uint32_t>& point_order() const { return m_order; }
+    // point index in the original array -> new point index
+    const std::vector<std::uint32_t>& inverse_point_order() const { return m_inverse_order; }
+    // nodes[0] is the root
+    const std::vector<Point_octree_node>& nodes() const { return m_nodes; }
+
+  private:
+    Eigen::Vector3f point(std::size_t i) const {
+      return Eigen::Vector3f(m_positions[3 * i], m_positions[3 * i + 1], m_positions[3 * i + 2]);
+    }
+
+    std::int32_t build_node(std::size_t begin, std::size_t end, const Eigen::AlignedBox3f& cube, int depth) {
+      const std::int32_t index = static_cast<std::int32_t>(m_nodes.size());
+      const int grid = POINT_OCTREE_GRID;
+      const float size = cube.sizes().x();
+
+      Point_octree_node node {cube, begin, end - begin, size / grid, depth, {}};
+      node.children.fill(-1);
+      m_nodes.push_back(node);
+
+      if (end - begin <= POINT_OCTREE_LEAF_SIZE || depth >= POINT_OCTREE_MAX_DEPTH) return index;
+
+      // Subsample: the first point of each grid cell stays in the node
+      std::unordered_set<std::uint64_t> cells;
+      cells.reserve(std::min<std::size_t>(end - begin, std::size_t(grid) * grid * 4));
+      std::size_t nbKept = begin;
+      for (std::size_t i = begin; i < end; ++i) {
+        const Eigen::Vector3f p = (point(m_order[i]) - cube.min()) * (grid / size);
+        std::uint64_t cell = 0;
+        for (int c = 0; c < 3; ++c) {
+          cell = cell * grid + std::uint64_t(std::clamp(int(p[c]), 0, grid - 1));
+        }
+
+        if (cells.insert(cell).second) {
+          std::swap(m_order[i], m_order[nbKept++]);
+        }
+      }
+      m_nodes[index].count = nbKept - begin;
+
+      // The other points are sorted by octant (counting sort)
+      const Eigen::Vector3f center = cube.center();
+      auto octant = [&](std::uint32_t i) {
+        const Eigen::Vector3f p = point(i);
+        return (p.x() >= center.x() ? 1 : 0) | (p.y() >= center.y() ? 2 : 0) | (p.z() >= center.z() ? 4 : 0);
+      };
+
+      std::array<std::size_t, 9> offsets {};
+      for (std::size_t i = nbKept; i < end; ++i) { ++offsets[octant(m_order[i]) + 1]; }
+      for (int o = 0; o < 8; ++o) { offsets[o + 1] += offsets[o]; }
+
+      std::array<std::size_t, 8> cursors;
+      std::copy(offsets.begin(), offsets.begin() + 8, cursors.begin());
+      for (std::size_t i = nbKept; i < end; ++i) {
+        m_buffer[nbKept + cursors[octant(m_order[i])]++] = m_order[i];
+      }
+      std::copy(m_buffer.begin() + nbKept, m_buffer.begin() + end, m_order.begin() + nbKept);
+
+      for (int o = 0; o < 8; ++o) {
+        if (offsets[o] == offsets[o + 1]) continue;
+
+        Eigen::AlignedBox3f childCube = cube;
+        for (int c = 0; c < 3; ++c) {
+          if (o & (1 << c)) { childCube.min()[c] = center[c]; }
+          else              { childCube.max()[c] = center[c]; }
+        }
+
+        const std::int32_t child = build_node(nbKept + offsets[o], nbKept + offsets[o + 1], childCube, depth + 1);
+        m_nodes[index].children[o] = child;
+      }
+
+      return index;
+    }
+
+    const float* m_positions = nullptr;
+    std::vector<std::uint32_t> m_order;
+    std::vector<std::uint32_t> m_inverse_order;
+    std::vector<std::uint32_t> m_buffer;
+    std::vector<Point_octree_node> m_nodes;
+  };
+}
@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace CGAL::GLFW {
+  /**
+   * Reads the vertices and the polygons of an OFF (ASCII) or PLY (ASCII or binary) file a part at a time,
+   * so that what is read can be drawn before the end of the file. open() only reads the header, each call
+   * to read() the next elements, in the order of the file, until about the given number of bytes is parsed.
+   * Polygons are stored flat: the vertices of polygon f are polygon_vertices()[polygon_offsets()[f] .. [f+1]).
+   */
+  class Polygon_file_reader {
+  public:
+    // The extension of filename is .off or .ply (other files are not tried)
+    static bool is_supported(const std::string& filename) {
+      const std::size_t dot = filename.find_last_of('.');
+      if (dot == std::string::npos) return false;
+
+      std::string extension = filename.substr(dot + 1);
+      std::transform(extension.begin(), extension.end(), extension.begin(),
+                     [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      return extension == "off" || extension == "ply";
+    }
+
+    // Reads the header, false if the file cannot be opened or is not a supported OFF or PLY file
+    bool open(const std::string& filename) {
+      m_file.open(filename, std::ios::binary);
+      m_buffer.assign(BUFFER_SIZE + 1, '\0');
+      m_begin = m_end = 0;
+      m_eof = false;
+      m_failed = !m_file;
+      if (m_failed) return false;
+
+      std::error_code error;
+      m_file_size = static_cast<std::size_t>(std::filesystem::file_size(filename, error));
+      if (error) { m_file_size = 0; }
+
+      fill(16);
+      const bool ply = m_end - m_begin >= 3 && std::memcmp(&m_buffer[m_begin], "ply", 3) == 0;
+      m_failed = !(ply ? read_ply_header() : read_off_header());
+      return !m_failed;
+    }
+
+    // Parses the next elements, about bytes bytes. Returns false once the file is read or on error.
+    bool read(std::size_t bytes) {
+      if (m_failed || done()) return false;
+
+      m_parsed = 0;
+      while (!done() && m_parsed < bytes) {
+        if (!read_element()) {
+          m_failed = true;
+          return false;
+        }
+      }
+      return !done();
+    }
+
+    bool failed() const { return m_failed; }
+    bool done() const { return m_element >= m_elements.size(); }
+
+    // Declared in the header
+    std::size_t nb_vertices() const { return m_nb_vertices; }
+    std::size_t nb_polygons() const { return m_nb_polygons; }
+
+    // Read so far
+    const std::vector<double>& points() const { return m_points; } // 3 coordinates per vertex
+    const std::vector<std::uint32_t>& polygon_vertices() const { return m_polygon_vertices; }
+    const std::vector<std::size_t>& polygon_offsets() const { return m_polygon_offsets; } // nb polygons + 1
+
+    // Frees the points and polygons read so far
+    void clear() {
+      std::vector<double>().swap(m_points);
+      std::vector<std::uint32_t>().swap(m_polygon_vertices);
+      std::vector<std::size_t>(1, 0).swap(m_polygon_offsets);
+    }
+
+  private:
+    static const std::size_t BUFFER_SIZE = 1 << 22;
+    static const std::size_t MAX_ELEMENT_SIZE = 1 << 16; // bytes of one line or one binary element
+
+    enum Type { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, NO_TYPE };
+    enum Role { OTHER, X, Y, Z, INDICES };
+    enum Format { OFF, PLY_ASCII, PLY_BINARY_LITTLE_ENDIAN, PLY_BINARY_BIG_ENDIAN };
+
+    struct Property {
+      Type type = NO_TYPE;       // of the value, or of the items of a list
+      Type count_type = NO_TYPE; // of the size of a list, NO_TYPE if not a list
+      Role role = OTHER;
+    };
+
+    struct Element {
+      std::size_t count = 0;
+      bool vertex = false;
+      bool polygon = false;
+      std::vector<Property> properties; // PLY only
+    };
+
+    /************* BUFFER *************/
+
+    // At least n bytes after m_begin, unless the end of the file is reached. The buffer ends with a '\0'
+    // sentinel for strtod.
+    void fill(std::size_t n) {
+      if (m_end - m_begin >= n || m_eof) return;
+
+      std::memmove(&m_buffer[0], &m_buffer[m_begin], m_end - m_begin);
+      m_end -= m_begin;
+      m_begin = 0;
+      m_file.read(&m_buffer[m_end], BUFFER_SIZE - m_end);
+      m_end += static_cast<std::size_t>(m_file.gcount());
+      m_eof = m_end < BUFFER_SIZE;
+      m_buffer[m_end] = '\0';
+    }
+
+    bool at_end() {
+      fill(1);
+      return m_begin >= m_end;
+    }
+
+    // Skips spaces, and comments starting with '#' in OFF files
+    void skip_spaces(bool newlines = true) {
+      for (;;) {
+        fill(1);
+        if (m_begin >= m_end) return;
+        const char c = m_buffer[m_begin];
+        if (c == '#' && m_format == OFF) {
+          skip_line();
+          continue;
+        }
+        if (c == '\n' && !newlines) return;
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return;
+        ++m_begin;
+      }
+    }
+
+    void skip_line() {
+      for (;;) {
+        fill(1);
+        if (m_begin >= m_end) return;
+        if (m_buffer[m_begin++] == '\n') return;
+      }
+    }
+
+    std::string token() {
+      skip_spaces();
+      std::string s;
+      for (fill(64); m_begin < m_end && !std::isspace(static_cast<unsigned char>(m_buffer[m_begin])); fill(64)) {
+        s += m_buffer[m_begin++];
+      }
+      return s;
+    }
+
+    std::string line() {
+      std::string s;
+      for (fill(1); m_begin < m_end && m_buffer[m_begin] != '\n'; fill(1)) { s += m_buffer[m_begin++]; }
+      if (m_begin < m_end) { ++m_begin; }
+      if (!s.empty() && s.back() == '\r') { s.pop_back(); }
+      return s;
+    }
+
+    // ASCII numbers of the current element (fill(MAX_ELEMENT_SIZE) was called for it)
+    bool parse_double(double& value) {
+      skip_spaces(m_format == OFF);
+      char* end = nullptr;
+      value = std::strtod(&m_buffer[m_begin], &end);
+      if (end == &m_buffer[m_begin]) return false;
+      m_begin = static_cast<std::size_t>(end - &m_buffer[0]);
+      return true;
+    }
+
+    bool parse_size(std::size_t& value) {
+      skip_spaces(m_format == OFF);
+      std::size_t i = m_begin;
+      value = 0;
+      while (i < m_end && m_buffer[i] >= '0' && m_buffer[i] <= '9') { value = 10 * value + (m_buffer[i++] - '0'); }
+      if (i == m_begin) return false;
+      m_begin = i;
+      return true;
+    }
+
+    /************* HEADERS *************/
+
+    // [ST][C][N][4]OFF, then the numbers of vertices, faces and edges
+    bool read_off_header() {
+      m_format = OFF;
+      std::string keyword = token();
+      if (keyword.size() < 3 || keyword.compare(keyword.size() - 3, 3, "OFF") != 0 || keyword.find('4') != std::string::npos ||
+          keyword.find('n') != std::string::npos) {
+        return false;
+      }
+      skip_spaces(false);
+      fill(16);
+      if (m_begin + 6 <= m_end && std::memcmp(&m_buffer[m_begin], "BINARY", 6) == 0) return false;
+
+      std::size_t nbVertices = 0, nbFaces = 0;
+      fill(MAX_ELEMENT_SIZE);
+      if (!parse_size(nbVertices) || !parse_size(nbFaces)) return false;
+      skip_line(); // number of edges
+
+      m_elements.clear();
+      m_elements.push_back({nbVertices, true, false, {}});
+      m_elements.push_back({nbFaces, false, true, {}});
+      return start();
+    }
+
+    static Type type_of(const std::string& name) {
+      static const char* const names[][2] = {{"char", "int8"}, {"uchar", "uint8"}, {"short", "int16"}, {"ushort", "uint16"},
+                                             {"int", "int32"}, {"uint", "uint32"}, {"float", "float32"}, {"double", "float64"}};
+      for (int t = 0; t < NO_TYPE; ++t) {
+        if (name == names[t][0] || name == names[t][1]) return static_cast<Type>(t);
+      }
+      return NO_TYPE;
+    }
+
+    bool read_ply_header() {
+      if (line() != "ply") return false;
+
+      m_elements.clear();
+      bool hasFormat = false;
+      for (;;) {
+        if (at_end()) return false;
+        std::string l = line();
+        std::vector<std::string> words;
+        for (std::size_t i = 0; i < l.size();) {
+          while (i < l.size() && std::isspace(static_cast<unsigned char>(l[i]))) { ++i; }
+          std::size_t j = i;
+          while (j < l.size() && !std::isspace(static_cast<unsigned char>(l[j]))) { ++j; }
+          if (j > i) { words.push_back(l.substr(i, j - i)); }
+          i = j;
+        }
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info") continue;
+
+        if (words[0] == "end_header") break;
+        if (words[0] == "format" && words.size() >= 2) {
+          if (words[1] == "ascii") { m_format = PLY_ASCII; }
+          else if (words[1] == "binary_little_endian") { m_format = PLY_BINARY_LITTLE_ENDIAN; }
+          else if (words[1] == "binary_big_endian") { m_format = PLY_BINARY_BIG_ENDIAN; }
+          else return false;
+          hasFormat = true;
+        } else if (words[0] == "element" && words.size() >= 3) {
+          Element element;
+          element.count = std::strtoull(words[2].c_str(), nullptr, 10);
+          element.vertex = words[1] == "vertex";
+          element.polygon = words[1] == "face";
+          m_elements.push_back(element);
+        } else if (words[0] == "property" && !m_elements.empty()) {
+          Property property;
+          const bool list = words.size() >= 5 && words[1] == "list";
+          if (list) {
+            property.count_type = type_of(words[2]);
+            property.type = type_of(words[3]);
+            if (property.count_type == NO_TYPE) return false;
+          } else if (words.size() >= 3) {
+            property.type = type_of(words[1]);
+          }
+          if (property.type == NO_TYPE) return false;
+
+          const std::string& name = words.back();
+          Element& element = m_elements.back();
+          if (element.vertex && !list) { property.role = name == "x" ? X : (name == "y" ? Y : (name == "z" ? Z : OTHER)); }
+          if (element.polygon && list && (name == "vertex_indices" || name == "vertex_index")) { property.role = INDICES; }
+          element.properties.push_back(property);
+        } else {
+          return false;
+        }
+      }
+      if (!hasFormat) return false;
+
+      for (const Element& element : m_elements) {
+        bool roles[INDICES + 1] = {};
+        for (const Property& property : element.properties) { roles[property.role] = true; }
+        if (element.vertex && !(roles[X] && roles[Y] && roles[Z])) return false;
+        if (element.polygon && !roles[INDICES]) return false;
+      }
+      return start();
+    }
+
+    bool start() {
+      m_nb_vertices = m_nb_polygons = 0;
+      for (const Element& element : m_elements) {
+        if (element.vertex) { m_nb_vertices += element.count; }
+        if (element.polygon) { m_nb_polygons += element.count; }
+      }
+      if (m_nb_vertices > UINT32_MAX) return false;
+
+      // The counts of the header are not trusted beyond what the file can hold: a vertex takes at least 3 bytes
+      // (binary PLY with 8 bits coordinates), a polygon at least 1
+      clear();
+      m_points.reserve(3 * std::min(m_nb_vertices, m_file_size / 3));
+      m_polygon_offsets.reserve(std::min(m_nb_polygons, m_file_size) + 1);
+      m_element = 0;
+      m_index = 0;
+      skip_empty_elements();
+      return true;
+    }
+
+    void skip_empty_elements() {
+      while (m_element < m_elements.size() && m_index >= m_elements[m_element].count) {
+        ++m_element;
+        m_index = 0;
+      }
+    }
+
+    /************* ELEMENTS *************/
+
+    static std::size_t type_size(Type type) {
+      static const std::size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+      return sizes[type];
+    }
+
+    // Binary value at m_begin
+    double binary_value(Type type) {
+      unsigned char bytes[8];
+      const std::size_t size = type_size(type);
+      std::memcpy(bytes, &m_buffer[m_begin], size);
+      m_begin += size;
+      m_parsed += size;
+
+      const std::uint16_t one = 1;
+      const bool littleEndian = *reinterpret_cast<const unsigned char*>(&one) == 1;
+      if (littleEndian != (m_format == PLY_BINARY_LITTLE_ENDIAN)) { std::reverse(bytes, bytes + size); }
+
+      switch (type) {
+        case INT8: { std::int8_t v; std::memcpy(&v, bytes, 1); return v; }
+        case UINT8: { std::uint8_t v; std::memcpy(&v, bytes, 1); return v; }
+        case INT16: { std::int16_t v; std::memcpy(&v, bytes, 2); return v; }
+        case UINT16: { std::uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+        case INT32: { std::int32_t v; std::memcpy(&v, bytes, 4); return v; }
+        case UINT32: { std::uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+        case FLOAT32: { float v; std::memcpy(&v, bytes, 4); return v; }
+        case FLOAT64: { double v; std::memcpy(&v, bytes, 8); return v; }
+        default: return 0;
+      }
+    }
+
+    bool value(Type type, double& v) {
+      if (m_format == PLY_ASCII || m_format == OFF) {
+        const std::size_t begin = m_begin;
+        const bool parsed = parse_double(v);
+        m_parsed += m_begin - begin;
+        return parsed;
+      }
+      fill(8);
+      if (m_end - m_begin < type_size(type)) return false;
+      v = binary_value(type);
+      return true;
+    }
+
+    bool add_index(double v) {
+      if (!(v >= 0 && v < static_cast<double>(m_nb_vertices))) return false;
+      m_polygon_vertices.push_back(static_cast<std::uint32_t>(v));
+      return true;
+    }
+
+    bool read_element() {
+      const Element& element = m_elements[m_element];
+      fill(MAX_ELEMENT_SIZE);
+      if (m_begin >= m_end) return false;
+
+      if (m_format == OFF) {
+        const std::size_t begin = m_begin;
+        if (!read_off_element(element)) return false;
+        skip_line(); // colors, texture coordinates...
+        m_parsed += m_begin - begin;
+      } else {
+        double xyz[3] = {0, 0, 0};
+        for (const Property& property : element.properties) {
+          double v = 0;
+          if (property.count_type == NO_TYPE) {
+            if (!value(property.type, v)) return false;
+            if (property.role >= X && property.role <= Z) { xyz[property.role - X] = v; }
+            continue;
+          }
+
+          double count = 0;
+          if (!value(property.count_type, count) || !(count >= 0)) return false;
+          for (std::size_t i = 0; i < static_cast<std::size_t>(count); ++i) {
+            if (!value(property.type, v)) return false;
+            if (property.role == INDICES && !add_index(v)) return false;
+          }
+        }
+        if (element.vertex) { m_points.insert(m_points.end(), xyz, xyz + 3); }
+        if (element.polygon) { m_polygon_offsets.push_back(m_polygon_vertices.size()); }
+        if (m_format == PLY_ASCII) { skip_line(); }
+      }
+
+      ++m_index;
+      skip_empty_elements();
+      return true;
+    }
+
+    bool read_off_element(const Element& element) {
+      if (element.vertex) {
+        double xyz[3];
+        for (double& v : xyz) {
+          if (!parse_double(v)) return false;
+        }
+        m_points.insert(m_points.end(), xyz, xyz + 3);
+        return true;
+      }
+
+      std::size_t count = 0;
+      if (!parse_size(count)) return false;
+      for (std::size_t i = 0; i < count; ++i) {
+        std::size_t index = 0;
+        if (!parse_size(index) || !add_index(static_cast<double>(index))) return false;
+      }
+      m_polygon_offsets.push_back(m_polygon_vertices.size());
+      return true;
+    }
+
+    std::ifstream m_file;
+    std::vector<char> m_buffer;
+    std::size_t m_begin = 0; // unread bytes of the buffer: [m_begin, m_end)
+    std::size_t m_end = 0;
+    bool m_eof = false;
+    bool m_failed = false;
+    std::size_t m_file_size = 0; // 0 if unknown
+    std::size_t m_parsed = 0; // by the current call to read()
+
+    Format m_format = OFF;
+    std::vector<Element> m_elements;
+    std::size_t m_element = 0; // current element and index in it
+    std::size_t m_index = 0;
+    std::size_t m_nb_vertices = 0;
+    std::size_t m_nb_polygons = 0;
+
+    std::vector<double> m_points;
+    std::vector<std::uint32_t> m_polygon_vertices;
+    std::vector<std::size_t> m_polygon_offsets {0};
+  };
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "Bv_Settings.h"
+#include "Shader.h"
+
+#if OFFSCREEN_CONTEXT == OFFSCREEN_EGL
+#include <EGL/egl.h>
+#endif
+
+namespace CGAL::GLFW {
+  /**
+   * Builds the programs of a context at once.
+   * A program linked before with the same sources by the same driver is loaded from the cache
+   * directory (glProgramBinary, one file per program named after the hash of its sources). The
+   * other ones are all compiled and linked before any status is read, so that drivers with
+   * KHR_parallel_shader_compile (or the ARB version) compile them concurrently, then their binaries
+   * are saved for the next contexts and the next runs.
+   */
+  class Program_builder {
+  public:
+    // Empty directory: no cache
+    explicit Program_builder(const std::string& directory) : m_directory(directory) {}
+
+    // target receives the program in build()
+    void add(Shader& target, const std::string& vertex, const std::string& fragment, const std::string& name) {
+      m_jobs.emplace_back(target, vertex, fragment, name);
+    }
+
+    // The context must be current
+    void build() {
+      const bool useCache = init_cache();
+      enable_parallel_compilation();
+
+      for (Job& job : m_jobs) {
+        if (useCache) {
+          char hash[17];
+          std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(source_hash(job)));
+          job.path = (std::filesystem::path(m_directory) / (std::string(hash) + ".bin")).string();
+          job.cached = load_binary(job);
+        }
+        if (!job.cached) { compile(job); }
+      }
+
+      // Statuses are only read once everything is submitted
+      for (Job& job : m_jobs) {
+        GLint linked = GL_FALSE;
+        if (job.cached) {
+          glGetProgramiv(job.program, GL_LINK_STATUS, &linked);
+          if (linked) {
+            ++m_nb_loaded;
+          } else {
+            // binary refused by the driver (updated since), compiled again
+            glDeleteProgram(job.program);
+            job.cached = false;
+            compile(job);
+          }
+        }
+        if (!job.cached) {
+          Shader::checkCompileErrors(job.vertex_shader, "VERTEX", job.name);
+          Shader::checkCompileErrors(job.fragment_shader, "FRAGMENT", job.name);
+          Shader::checkCompileErrors(job.program, "PROGRAM", job.name);
+          glDeleteShader(job.vertex_shader);
+          glDeleteShader(job.fragment_shader);
+
+          glGetProgramiv(job.program, GL_LINK_STATUS, &linked);
+          if (linked && useCache) { save_binary(job); }
+        }
+        *job.target = Shader(job.program);
+      }
+      m_jobs.clear();
+    }
+
+    // Programs of the last builds loaded from the cache
+    std::size_t nb_loaded() const { return m_nb_loaded; }
+
+    // Default cache directory, in the cache directory of the user (%LOCALAPPDATA%, ~/Library/Caches,
+    // $XDG_CACHE_HOME or ~/.cache), empty when none is known. Never a shared directory: a binary
+    // written there by another user would be loaded as is.
+    static std::string default_directory() {
+      std::filesystem::path base;
+#if defined(_WIN32)
+      if (const char* local = std::getenv("LOCALAPPDATA")) { base = local; }
+#elif defined(__APPLE__)
+      if (const char* home = std::getenv("HOME")) { base = std::filesystem::path(home) / "Library" / "Caches"; }
+#else
+      if (const char* cache = std::getenv("XDG_CACHE_HOME")) { base = cache; }
+      // relative values are invalid per the specification
+      if (!base.is_absolute()) {
+        base.clear();
+        if (const char* home = std::getenv("HOME")) { base = std::filesystem::path(home) / ".cache"; }
+      }
+#endif
+      if (base.empty() || !base.is_absolute()) return std::string();
+      return (base / "cgal_basic_viewer" / "programs").string();
+    }
+
+  private:
+    struct Job {
+      Job(Shader& target, const std::string& vertex, const std::string& fragment, const std::string& name)
+          : target(&target), vertex(vertex), fragment(fragment), name(name) {}
+
+      Shader* target;
+      std::string vertex;
+      std::string fragment;
+      std::string name;
+      std::string path;
+      bool cached = false;
+      GLuint program = 0;
+      GLuint vertex_shader = 0;
+      GLuint fragment_shader = 0;
+    };
+
+    static constexpr char MAGIC[4] = {'B', 'V', 'P', 'B'};
+
+    bool init_cache() {
+      if (m_directory.empty() || glGetProgramBinary == nullptr || glProgramBinary == nullptr) return false;
+
+      GLint nbFormats = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nbFormats);
+      if (nbFormats <= 0) return false;
+
+      std::error_code error;
+      // only readable by the user when created here
+      if (std::filesystem::create_directories(m_directory, error)) {
+        std::filesystem::permissions(m_directory, std::filesystem::perms::owner_all,
+                                     std::filesystem::perm_options::replace, error);
+      }
+      if (error) return false;
+
+      // Binaries are only valid for the driver that produced them
+      auto str = [](GLenum name) {
+        const GLubyte* s = glGetString(name);
+        return s != nullptr ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+      };
+      m_driver = str(GL_VENDOR) + '\n' + str(GL_RENDERER) + '\n' + str(GL_VERSION);
+      return true;
+    }
+
+    static bool has_extension(const char* name) {
+      GLint nbExtensions = 0;
+      glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+      for (GLint i = 0; i < nbExtensions; ++i) {
+        const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+        if (extension != nullptr && std::strcmp(reinterpret_cast<const char*>(extension), name) == 0) return true;
+      }
+      return false;
+    }
+
+    static void* proc_address(const char* name) {
+#if OFFSCREEN_CONTEXT == OFFSCREEN_EGL
+      if (eglGetCurrentContext() != EGL_NO_CONTEXT) return reinterpret_cast<void*>(eglGetProcAddress(name));
+#endif
+      return reinterpret_cast<void*>(glfwGetProcAddress(name));
+    }
+
+    // Lets the driver use as many compiler threads as it wants, compilations then run in the background
+    // until their status is read
+    static void enable_parallel_compilation() {
+      typedef void (APIENTRYP Max_threads_proc)(GLuint count);
+      const char* function = nullptr;
+      if (has_extension("GL_KHR_parallel_shader_compile")) {
+        function = "glMaxShaderCompilerThreadsKHR";
+      } else if (has_extension("GL_ARB_parallel_shader_compile")) {
+        function = "glMaxShaderCompilerThreadsARB";
+      }
+      if (function == nullptr) return;
+
+      Max_threads_proc maxThreads = reinterpret_cast<Max_threads_proc>(proc_address(function));
+      if (maxThreads != nullptr) { maxThreads(0xFFFFFFFFu); }
+    }
+
+    // FNV-1a of the sources
+    static std::uint64_t source_hash(const Job& job) {
+      std::uint64_t hash = 14695981039346656037ull;
+      for (const std::string* s : {&job.vertex, &job.fragment}) {
+        for (unsigned char c : *s) {
+          hash = (hash ^ c) * 1099511628211ull;
+        }
+        hash = (hash ^ 0xFF) * 1099511628211ull; // separator
+      }
+      return hash;
+    }
+
+    // Starts the compilation and the link without waiting for them
+    void compile(Job& job) {
+      const char* source = job.vertex.c_str();
+      job.vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+      glShaderSource(job.vertex_shader, 1, &source, nullptr);
+      glCompileShader(job.vertex_shader);
+
+      source = job.fragment.c_str();
+      job.fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+      glShaderSource(job.fragment_shader, 1, &source, nullptr);
+      glCompileShader(job.fragment_shader);
+
+      job.program = glCreateProgram();
+      glAttachShader(job.program, job.vertex_shader);
+      glAttachShader(job.program, job.fragment_shader);
+      if (!m_driver.empty()) { glProgramParameteri(job.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); }
+      glLinkProgram(job.program);
+    }
+
+    // File: magic, driver string, sources (to rule out hash collisions), binary format and binary
+    bool load_binary(Job& job) {
+      std::ifstream file(job.path, std::ios::binary);
+      if (!file) return false;
+
+      char magic[4];
+      std::string driver, vertex, fragment;
+      std::uint32_t format = 0;
+      std::vector<char> binary;
+      if (!file.read(magic, 4) || std::memcmp(magic, MAGIC, 4) != 0) return false;
+      if (!read_string(file, driver) || driver != m_driver) return false;
+      if (!read_string(file, vertex) || vertex != job.vertex) return false;
+      if (!read_string(file, fragment) || fragment != job.fragment) return false;
+      if (!file.read(reinterpret_cast<char*>(&format), sizeof(format)) || !read_bytes(file, binary)) return false;
+
+      job.program = glCreateProgram();
+      glProgramBinary(job.program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+      return true;
+    }
+
+    void save_binary(const Job& job) const {
+      GLint length = 0;
+      glGetProgramiv(job.program, GL_PROGRAM_BINARY_LENGTH, &length);
+      if (length <= 0) return;
+
+      std::vector<char> binary(length);
+      GLenum format = 0;
+      glGetProgramBinary(job.program, length, &length, &format, binary.data());
+      binary.resize(length);
+
+      // Written aside then renamed, concurrent viewers never read a partial file
+      const std::string temporary = job.path + ".tmp";
+      {
+        std::ofstream file(temporary, std::ios::binary);
+        const std::uint32_t format32 = format;
+        file.write(MAGIC, 4);
+        write_string(file, m_driver);
+        write_string(file, job.vertex);
+        write_string(file, job.fragment);
+        file.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+        write_string(file, std::string(binary.begin(), binary.end()));
+        if (!file) return;
+      }
+      std::error_code error;
+      std::filesystem::rename(temporary, job.path, error);
+    }
+
+    static void write_string(std::ofstream& file, const std::string& s) {
+      const std::uint64_t size = s.size();
+      file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      file.write(s.data(), s.size());
+    }
+
+    template <class Container>
+    static bool read_container(std::ifstream& file, Container& c) {
+      std::uint64_t size = 0;
+      if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > (1u << 30)) return false;
+      c.resize(size);
+      return size == 0 || static_cast<bool>(file.read(&c[0], size));
+    }
+    static bool read_string(std::ifstream& file, std::string& s) { return read_container(file, s); }
+    static bool read_bytes(std::ifstream& file, std::vector<char>& bytes) { return read_container(file, bytes); }
+
+    std::string m_directory;
+    std::string m_driver; // empty without cache
+    std::vector<Job> m_jobs;
+    std::size_t m_nb_loaded = 0;
+  };
+}
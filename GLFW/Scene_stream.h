@@ -0,0 +1,142 @@
+#pragma once
+
+#include <CGAL/Graphics_scene.h>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Direct_mesh.h"
+#include "Graphics_scene_access.h"
+#include "Lod.h"
+
+namespace CGAL::GLFW {
+  /**
+   * Parts of a scene produced by another thread (a file being read...) while the viewer shows what is already
+   * there (see Basic_Viewer::scene_stream). The producer appends chunks, the arrays of a scene appended to the
+   * ones of the target scene, and may replace the whole scene at the end, then calls finish(). The viewer
+   * applies them to the target scene between two frames, only then the target scene is modified. A replacement
+   * becomes the target scene of the next chunks. Chunks are dropped without CGAL_GLFW_GRAPHICS_SCENE_ACCESS.
+   */
+  class Scene_stream {
+  public:
+    struct Chunk {
+      std::vector<float> arrays[Graphics_scene::LAST_INDEX]; // Graphics_scene::POS_MONO_POINTS...
+      Eigen::AlignedBox3f box;                                // of the positions
+    };
+
+    // Scene drawn instead of the target scene, with the meshes drawn along with it (see Basic_Viewer::lod_mesh,
+    // direct_mesh and lod_fallback_faces), which must outlive the viewer
+    struct Replacement {
+      std::shared_ptr<Graphics_scene> scene;
+      const Lod_mesh* lod = nullptr;
+      const Direct_mesh* direct = nullptr;
+      std::function<void()> lod_fallback_faces;
+    };
+
+    /************* PRODUCER *************/
+
+    void append(Chunk&& chunk) {
+      push({std::make_shared<Chunk>(std::move(chunk)), Replacement()});
+    }
+
+    // replacement.scene is kept by the stream until it is destroyed
+    void replace(Replacement replacement) { push({nullptr, std::move(replacement)}); }
+
+    // After the last chunk
+    void finish() {
+      m_finished = true;
+      notify();
+    }
+
+    // Set by the consumer when it does not need the next chunks (the viewer is closed)
+    void cancel() { m_cancelled = true; }
+    bool cancelled() const { return m_cancelled; }
+
+    /************* CONSUMER *************/
+
+    // callback is called by the producer thread after each push and by finish(). It is never called once
+    // on_push returns, the previous callback may be running until then.
+    void on_push(std::function<void()> callback) {
+      std::lock_guard<std::mutex> lock(m_callback_mutex);
+      m_on_push = std::move(callback);
+    }
+
+    // Applies the pending updates to scene, or to the scene of the last replacement, which is copied to
+    // replacement. Returns true if there was any.
+    bool update(Graphics_scene& scene, Replacement& replacement) {
+      std::deque<Update> updates;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        updates.swap(m_updates);
+      }
+
+      Graphics_scene* target = m_replacement != nullptr ? m_replacement.get() : &scene;
+      for (Update& update : updates) {
+        if (update.replacement.scene != nullptr) {
+          m_replacement = update.replacement.scene;
+          target = m_replacement.get();
+          replacement = std::move(update.replacement);
+          continue;
+        }
+
+#if CGAL_GLFW_GRAPHICS_SCENE_ACCESS
+        for (int i = 0; i < Graphics_scene::LAST_INDEX; ++i) {
+          const std::vector<float>& source = update.chunk->arrays[i];
+          std::vector<float>& array = Graphics_scene_access::array(*target, i);
+          array.insert(array.end(), source.begin(), source.end());
+        }
+        const Eigen::AlignedBox3f& box = update.chunk->box;
+        if (!box.isEmpty()) {
+          Graphics_scene_access::bounding_box(*target) += CGAL::Bbox_3(box.min().x(), box.min().y(), box.min().z(),
+                                                                       box.max().x(), box.max().y(), box.max().z());
+        }
+#else
+        static_cast<void>(target);
+#endif
+      }
+      return !updates.empty();
+    }
+
+    // finish() was called and every update is applied
+    bool finished() const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_finished && m_updates.empty();
+    }
+
+  private:
+    struct Update {
+      std::shared_ptr<Chunk> chunk;
+      Replacement replacement;
+    };
+
+    void push(Update update) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_updates.push_back(std::move(update));
+      }
+      notify();
+    }
+
+    // The callback runs under its mutex, so that on_push({}) waits for it
+    void notify() {
+      std::lock_guard<std::mutex> lock(m_callback_mutex);
+      if (m_on_push) { m_on_push(); }
+    }
+
+    mutable std::mutex m_mutex;
+    std::deque<Update> m_updates;
+    std::shared_ptr<Graphics_scene> m_replacement; // applied, only used by the consumer
+    std::mutex m_callback_mutex;
+    std::function<void()> m_on_push;
+    std::atomic<bool> m_finished {false};
+    std::atomic<bool> m_cancelled {false};
+  };
+}
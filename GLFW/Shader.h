@@ -1,8 +1,10 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <iostream>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 class Shader { 
 public:
@@ -18,13 +20,13 @@ public:
     }
 
     int getUniform(const std::string& name) {
-        int loc = uniforms[name];
-        if (loc != 0){
-            return loc;
+        auto it = uniforms.find(name);
+        if (it != uniforms.end()){
+            return it->second;
         }
 
-        loc = glGetUniformLocation(program, name.c_str());
-        uniforms[name] = loc;
+        int loc = glGetUniformLocation(program, name.c_str());
+        uniforms.emplace(name, loc);
         return loc;
     }
 
@@ -32,14 +34,31 @@ public:
         glUniformMatrix4fv(getUniform(name), 1, transpose, data);
     }
 
-    void setVec4f(const std::string& name, GLfloat* data){
-        glUniform4fv(getUniform(name), 1, data);
+    void setVec3f(const std::string& name, GLfloat* data){
+        glUniform3fv(getUniform(name), 1, data);
+    }
+
+    void setVec4f(const std::string& name, GLfloat* data, GLsizei count = 1){
+        glUniform4fv(getUniform(name), count, data);
     }
     
     void setFloat(const std::string& name, float data){
         glUniform1f(getUniform(name), data);
     }
 
+    void setInt(const std::string& name, int data){
+        glUniform1i(getUniform(name), data);
+    }
+
+    // Uniforms set per draw, with a location queried once by getUniform
+    void setFloat(int location, float data){
+        glUniform1f(location, data);
+    }
+
+    void setVec4f(int location, GLfloat* data){
+        glUniform4fv(location, 1, data);
+    }
+
     static Shader loadShader(std::string src_vertex, std::string src_fragment, std::string name="") {
       unsigned int vshader = glCreateShader(GL_VERTEX_SHADER);
       const char* source_ = src_vertex.c_str();  
@@ -66,10 +85,6 @@ public:
       return Shader(program);
     }
 
-private:
-    std::unordered_map<std::string, int> uniforms;
-    int program;
-
     static void checkCompileErrors(GLuint shader, std::string type, std::string name) {
         GLint success;
         GLchar infoLog[1024];
@@ -95,4 +110,8 @@ private:
             }
         }
     }
+
+private:
+    std::unordered_map<std::string, int> uniforms;
+    int program;
 };
\ No newline at end of file
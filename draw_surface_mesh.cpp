@@ -13,32 +13,37 @@ int main(int argc, char* argv[])
 
   std::cout << filename << std::endl;
   Mesh sm;
-  if(!CGAL::IO::read_polygon_mesh(filename, sm))
+
+  // OFF and PLY meshes are drawn while the file is read, other formats once they are read
+  bool read=CGAL::draw_streamed(filename, sm, [](Mesh& sm)
   {
-    std::cerr << "Invalid input file: " << filename << std::endl;
-    return EXIT_FAILURE;
-  }
+    // Internal color property maps are used if they exist and are called "v:color", "e:color" and "f:color".
+    auto vcm = sm.add_property_map<Mesh::Vertex_index, CGAL::IO::Color>("v:color").first;
+    auto ecm = sm.add_property_map<Mesh::Edge_index, CGAL::IO::Color>("e:color").first;
+    auto fcm = sm.add_property_map<Mesh::Face_index>("f:color", CGAL::IO::white() /*default*/).first;
 
-  // Internal color property maps are used if they exist and are called "v:color", "e:color" and "f:color".
-  auto vcm = sm.add_property_map<Mesh::Vertex_index, CGAL::IO::Color>("v:color").first;
-  auto ecm = sm.add_property_map<Mesh::Edge_index, CGAL::IO::Color>("e:color").first;
-  auto fcm = sm.add_property_map<Mesh::Face_index>("f:color", CGAL::IO::white() /*default*/).first;
+    for(auto v : vertices(sm))
+    {
+      if(v.idx()%2)
+      { put(vcm, v, CGAL::IO::black()); }
+      else
+      { put(vcm, v, CGAL::IO::blue()); }
+    }
 
-  for(auto v : vertices(sm))
-  {
-    if(v.idx()%2)
-    { put(vcm, v, CGAL::IO::black()); }
-    else
-    { put(vcm, v, CGAL::IO::blue()); }
-  }
+    for(auto e : edges(sm))
+    { put(ecm, e, CGAL::IO::gray()); }
 
-  for(auto e : edges(sm))
-  { put(ecm, e, CGAL::IO::gray()); }
+    if(!sm.is_empty())
+    { put(fcm, *(sm.faces().begin()), CGAL::IO::red()); }
 
-  put(fcm, *(sm.faces().begin()), CGAL::IO::red());
+    return CGAL::Graphics_scene_batch_options_surface_mesh<Point>(sm);
+  });
 
-  // Draw!
-  draw(sm);
+  if(!read)
+  {
+    std::cerr << "Invalid input file: " << filename << std::endl;
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS;
 }
@@ -93,12 +93,48 @@ void add_to_graphics_scene(const SM& sm,
 #include <CGAL/Graphics_scene_options.h>
 #include <CGAL/Surface_mesh.h>
 #include <CGAL/draw_face_graph.h>
+#include <CGAL/Polygon_mesh_processing/IO/polygon_mesh_io.h>
+#include <CGAL/Polygon_mesh_processing/bbox.h>
+#include <CGAL/Polygon_mesh_processing/orient_polygon_soup.h>
+#include <CGAL/Polygon_mesh_processing/polygon_soup_to_polygon_mesh.h>
+#include <CGAL/Polygon_mesh_processing/repair_polygon_soup.h>
 
 #define CAM_MOVE_SPEED 5.0f
 #include "GLFW/Basic_viewer_impl.h"
+#include "GLFW/Graphics_scene_access.h"
+#include "GLFW/Polygon_file_reader.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
 
 namespace CGAL {
 
+// Style of a vertex, an edge or a face given by the draw_*, colored_* and *_color callbacks of graphics scene options
+struct Graphics_scene_element_style
+{
+  bool drawn=true;
+  bool colored=false;
+  CGAL::IO::Color color;
+};
+
+// Range versions of the draw_*, colored_* and *_color callbacks of graphics scene options, called by 
+// add_to_graphics_scene_in_parallel from several threads on disjoint ranges: styles[i-first] receives the style
+// of the element of index i, for i in [first, last) (removed elements included). An empty callback: the per element
+// callbacks are called instead. add_to_graphics_scene builds the scene in parallel only for options giving the
+// callbacks of all their enabled elements.
+template <class SM>
+struct Graphics_scene_batch_callbacks
+{
+  using Styles=std::function<void(const SM&, std::size_t first, std::size_t last,
+                                  Graphics_scene_element_style* styles)>;
+  Styles vertex_styles, edge_styles, face_styles;
+};
+
 // Check if there are any color maps that could be used
 template <typename K>
 struct Graphics_scene_options_surface_mesh
@@ -155,37 +191,944 @@ private:
   typename SM::template Property_map<face_descriptor, CGAL::IO::Color> fcolors;
 };
 
+// Graphics_scene_options_surface_mesh with the batch callbacks of the same color maps, for which
+// add_to_graphics_scene builds the scene in parallel. Its per element callbacks are not called: use
+// Graphics_scene_options_surface_mesh to change draw_*, colored_* or *_color.
+template <typename K>
+struct Graphics_scene_batch_options_surface_mesh
+  : public Graphics_scene_options_surface_mesh<K>,
+    public Graphics_scene_batch_callbacks<::CGAL::Surface_mesh<K>>
+{
+  using SM = ::CGAL::Surface_mesh<K>;
+  using vertex_descriptor = typename boost::graph_traits<SM>::vertex_descriptor;
+  using edge_descriptor = typename boost::graph_traits<SM>::edge_descriptor;
+  using face_descriptor = typename boost::graph_traits<SM>::face_descriptor;
+  using Styles = typename Graphics_scene_batch_callbacks<SM>::Styles;
+
+  Graphics_scene_batch_options_surface_mesh(const SM& amesh)
+    : Graphics_scene_options_surface_mesh<K>(amesh)
+  {
+    this->vertex_styles=color_styles<vertex_descriptor>(amesh, "v:color");
+    this->edge_styles=color_styles<edge_descriptor>(amesh, "e:color");
+    this->face_styles=color_styles<face_descriptor>(amesh, "f:color");
+  }
+
+private:
+  // Drawn elements, colored by the map name if there is one
+  template <class Descriptor>
+  static Styles color_styles(const SM& amesh, const std::string& name)
+  {
+    using Style = Graphics_scene_element_style;
+    auto colors=amesh.template property_map<Descriptor, CGAL::IO::Color>(name);
+    if (!colors.second)
+    {
+      return [](const SM&, std::size_t first, std::size_t last, Style* styles)
+      { std::fill(styles, styles+(last-first), Style()); };
+    }
+    return [map=colors.first](const SM&, std::size_t first, std::size_t last, Style* styles)
+    {
+      for (std::size_t i=first; i<last; ++i)
+      { styles[i-first]={true, true, get(map, Descriptor(static_cast<typename SM::size_type>(i)))}; }
+    };
+  }
+};
+
+namespace internal {
+
+// Arrays of the scene filled by one block of elements
+struct Graphics_scene_block
+{
+  std::vector<float> arrays[Graphics_scene::LAST_INDEX];
+  float min[3]={ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+  float max[3]={ -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+  std::vector<std::pair<std::size_t, Graphics_scene_element_style>> polygons; // non convex faces, triangulated by the scene
+
+  void push(int index, const float* v)
+  { arrays[index].insert(arrays[index].end(), v, v+3); }
+
+  void push_position(int index, const float* p)
+  {
+    push(index, p);
+    for (int i=0; i<3; ++i)
+    {
+      min[i]=std::min(min[i], p[i]);
+      max[i]=std::max(max[i], p[i]);
+    }
+  }
+
+  void push_color(int index, const CGAL::IO::Color& c)
+  {
+    const float color[3]={ c.red()/255.f, c.green()/255.f, c.blue()/255.f };
+    push(index, color);
+  }
+};
+
+template <class SM, class GSOptions>
+const Graphics_scene_batch_callbacks<SM>& batch_callbacks(const GSOptions& gs_options)
+{
+  static const Graphics_scene_batch_callbacks<SM> none;
+  if constexpr (std::is_base_of<Graphics_scene_batch_callbacks<SM>, GSOptions>::value) { return gs_options; }
+  else { return none; }
+}
+
+// true if gs_options has the batch callbacks of all its enabled elements: no per element callback is then called
+template <class SM, class GSOptions>
+bool has_batch_callbacks(const GSOptions& gs_options)
+{
+  const Graphics_scene_batch_callbacks<SM>& batch=batch_callbacks<SM>(gs_options);
+  return (!gs_options.are_vertices_enabled() || batch.vertex_styles) &&
+         (!gs_options.are_edges_enabled() || batch.edge_styles) &&
+         (!gs_options.are_faces_enabled() || batch.face_styles);
+}
+
+// Styles of the elements of indices [first, last), from the batch callback if there is one
+template <class Descriptor, class SM, class Draw, class Colored, class Color>
+void element_styles(const SM& amesh, std::size_t first, std::size_t last,
+                    const typename Graphics_scene_batch_callbacks<SM>::Styles& batch,
+                    const Draw& draw, const Colored& colored, const Color& color,
+                    std::vector<Graphics_scene_element_style>& styles)
+{
+  styles.resize(last-first);
+  if (batch)
+  {
+    batch(amesh, first, last, styles.data());
+    return;
+  }
+
+  for (std::size_t i=first; i<last; ++i)
+  {
+    const Descriptor d(static_cast<typename SM::size_type>(i));
+    Graphics_scene_element_style& style=styles[i-first];
+    style.drawn=draw(amesh, d);
+    style.colored=style.drawn && colored(amesh, d);
+    if (style.colored) { style.color=color(amesh, d); }
+  }
+}
+
+// Calls work(block, first, last) for the blocks of blockSize indices of [0, n) from nbThreads threads
+template <class Work>
+void parallel_blocks(std::size_t n, std::size_t blockSize, unsigned nbThreads, const Work& work)
+{
+  const std::size_t nbBlocks=(n+blockSize-1)/blockSize;
+  std::atomic<std::size_t> next {0};
+  auto worker=[&]()
+  {
+    for (std::size_t b=next++; b<nbBlocks; b=next++)
+    { work(b, b*blockSize, std::min(n, (b+1)*blockSize)); }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::size_t i=1; i<std::min<std::size_t>(nbThreads, nbBlocks); ++i) { threads.emplace_back(worker); }
+  worker();
+  for (std::thread& thread : threads) { thread.join(); }
+}
+
+} // namespace internal
+
+#if CGAL_GLFW_GRAPHICS_SCENE_ACCESS
+/*
+ * Same as add_to_graphics_scene, built by nbThreads threads (0: one per core). The face normals, the vertex normals,
+ * then the elements of blocks of consecutive indices are computed in parallel, each block in its own arrays, 
+ * which are appended in order to the arrays of the scene at the end. The styles come from the batch callbacks of the
+ * options when they have them (see Graphics_scene_batch_callbacks), otherwise the per element callbacks are called
+ * concurrently: they must then be thread safe. add_to_graphics_scene only calls this function for options with all
+ * their batch callbacks. Convex faces are triangulated as fans, the scene triangulates the other ones.
+ */
+template<class K, class GSOptions>
+void add_to_graphics_scene_in_parallel(const Surface_mesh<K>& amesh,
+                                       CGAL::Graphics_scene &graphics_scene,
+                                       const GSOptions &gs_options,
+                                       unsigned nbThreads=0)
+{
+  using SM = Surface_mesh<K>;
+  using Style = Graphics_scene_element_style;
+  using Vertex_index = typename SM::Vertex_index;
+  using Edge_index = typename SM::Edge_index;
+  using Face_index = typename SM::Face_index;
+  using Halfedge_index = typename SM::Halfedge_index;
+  using Vector = typename CGAL::Kernel_traits<typename SM::Point>::Kernel::Vector_3;
+
+  static const std::size_t blockSize=1 << 16;
+  if (nbThreads == 0) { nbThreads=std::max(1u, std::thread::hardware_concurrency()); }
+
+  const Graphics_scene_batch_callbacks<SM>& batch=internal::batch_callbacks<SM>(gs_options);
+  const bool drawVertices=gs_options.are_vertices_enabled();
+  const bool drawEdges=gs_options.are_edges_enabled();
+  const bool drawFaces=gs_options.are_faces_enabled();
+  const std::size_t nbVertices=drawVertices || drawFaces ? amesh.num_vertices() : 0;
+  const std::size_t nbEdges=drawEdges ? amesh.num_edges() : 0;
+  const std::size_t nbFaces=drawFaces ? amesh.num_faces() : 0;
+  const bool hasGarbage=amesh.has_garbage();
+
+  auto position=[&](Vertex_index v, float* p)
+  {
+    const auto& point=amesh.point(v);
+    p[0]=static_cast<float>(CGAL::to_double(point.x()));
+    p[1]=static_cast<float>(CGAL::to_double(point.y()));
+    p[2]=static_cast<float>(CGAL::to_double(point.z()));
+  };
+
+  // Newell normals of the faces, then vertex normals averaging the normals of their faces (as draw_face_graph)
+  std::vector<float> faceNormals(3*nbFaces), vertexNormals(drawFaces ? 3*nbVertices : 0);
+  auto normalize=[](double* n, float* out)
+  {
+    const double length=std::sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+    for (int i=0; i<3; ++i) { out[i]=length>0 ? static_cast<float>(n[i]/length) : 0.f; }
+  };
+  internal::parallel_blocks(nbFaces, blockSize, nbThreads, [&](std::size_t, std::size_t first, std::size_t last)
+  {
+    for (std::size_t i=first; i<last; ++i)
+    {
+      const Face_index f(static_cast<typename SM::size_type>(i));
+      if (hasGarbage && amesh.is_removed(f)) { continue; }
+
+      double n[3]={0, 0, 0};
+      const Halfedge_index h0=amesh.halfedge(f);
+      Halfedge_index h=h0;
+      do
+      {
+        float p[3], q[3];
+        position(amesh.source(h), p);
+        position(amesh.target(h), q);
+        n[0]+=(double(p[1])-q[1])*(double(p[2])+q[2]);
+        n[1]+=(double(p[2])-q[2])*(double(p[0])+q[0]);
+        n[2]+=(double(p[0])-q[0])*(double(p[1])+q[1]);
+        h=amesh.next(h);
+      }
+      while (h != h0);
+      normalize(n, &faceNormals[3*i]);
+    }
+  });
+  internal::parallel_blocks(vertexNormals.size()/3, blockSize, nbThreads, [&](std::size_t, std::size_t first, std::size_t last)
+  {
+    for (std::size_t i=first; i<last; ++i)
+    {
+      const Vertex_index v(static_cast<typename SM::size_type>(i));
+      if ((hasGarbage && amesh.is_removed(v)) || amesh.halfedge(v) == SM::null_halfedge()) { continue; }
+
+      double n[3]={0, 0, 0};
+      for (Halfedge_index h : CGAL::halfedges_around_target(amesh.halfedge(v), amesh))
+      {
+        if (amesh.is_border(h)) { continue; }
+        const float* fn=&faceNormals[3*amesh.face(h).idx()];
+        for (int k=0; k<3; ++k) { n[k]+=fn[k]; }
+      }
+      normalize(n, &vertexNormals[3*i]);
+    }
+  });
+
+  // Elements, block by block
+  const std::size_t nbElements=std::max({nbVertices, nbEdges, nbFaces});
+  std::vector<internal::Graphics_scene_block> blocks((nbElements+blockSize-1)/blockSize);
+  internal::parallel_blocks(nbElements, blockSize, nbThreads, [&](std::size_t b, std::size_t first, std::size_t)
+  {
+    internal::Graphics_scene_block& block=blocks[b];
+    std::vector<Style> styles;
+    std::vector<float> points;
+    std::vector<Vertex_index> vertices;
+
+    const std::size_t lastFace=std::min(nbFaces, first+blockSize);
+    if (first < lastFace)
+    {
+      internal::element_styles<Face_index>(amesh, first, lastFace, batch.face_styles, gs_options.draw_face,
+                                           gs_options.colored_face, gs_options.face_color, styles);
+    }
+    for (std::size_t i=first; i<lastFace; ++i)
+    {
+      const Face_index f(static_cast<typename SM::size_type>(i));
+      const Style& style=styles[i-first];
+      if ((hasGarbage && amesh.is_removed(f)) || !style.drawn) { continue; }
+
+      // Same first vertex as draw_face_graph
+      points.clear();
+      vertices.clear();
+      const Halfedge_index h0=amesh.halfedge(f);
+      Halfedge_index h=h0;
+      do
+      {
+        vertices.push_back(amesh.source(h));
+        points.resize(points.size()+3);
+        position(vertices.back(), &points[points.size()-3]);
+        h=amesh.next(h);
+      }
+      while (h != h0);
+      if (vertices.size() < 3) { continue; }
+
+      const float* normal=&faceNormals[3*i];
+      bool convex=true;
+      for (std::size_t k=0; k<vertices.size() && convex && vertices.size()>3; ++k)
+      {
+        const float* p0=&points[3*k];
+        const float* p1=&points[3*((k+1)%vertices.size())];
+        const float* p2=&points[3*((k+2)%vertices.size())];
+        const double u[3]={double(p1[0])-p0[0], double(p1[1])-p0[1], double(p1[2])-p0[2]};
+        const double w[3]={double(p2[0])-p1[0], double(p2[1])-p1[1], double(p2[2])-p1[2]};
+        convex=(u[1]*w[2]-u[2]*w[1])*normal[0]+(u[2]*w[0]-u[0]*w[2])*normal[1]+(u[0]*w[1]-u[1]*w[0])*normal[2] >= 0;
+      }
+      if (!convex)
+      {
+        block.polygons.emplace_back(i, style);
+        continue;
+      }
+
+      const int pos=style.colored ? Graphics_scene::POS_COLORED_FACES : Graphics_scene::POS_MONO_FACES;
+      const int flat=style.colored ? Graphics_scene::FLAT_NORMAL_COLORED_FACES : Graphics_scene::FLAT_NORMAL_MONO_FACES;
+      const int smooth=style.colored ? Graphics_scene::SMOOTH_NORMAL_COLORED_FACES : Graphics_scene::SMOOTH_NORMAL_MONO_FACES;
+      for (std::size_t k=1; k+1<vertices.size(); ++k)
+      {
+        for (std::size_t corner : {std::size_t(0), k, k+1})
+        {
+          block.push_position(pos, &points[3*corner]);
+          block.push(flat, normal);
+          block.push(smooth, &vertexNormals[3*vertices[corner].idx()]);
+          if (style.colored) { block.push_color(Graphics_scene::COLOR_FACES, style.color); }
+        }
+      }
+    }
+
+    const std::size_t lastEdge=std::min(nbEdges, first+blockSize);
+    if (first < lastEdge)
+    {
+      internal::element_styles<Edge_index>(amesh, first, lastEdge, batch.edge_styles, gs_options.draw_edge,
+                                           gs_options.colored_edge, gs_options.edge_color, styles);
+    }
+    for (std::size_t i=first; i<lastEdge; ++i)
+    {
+      const Edge_index e(static_cast<typename SM::size_type>(i));
+      const Style& style=styles[i-first];
+      if ((hasGarbage && amesh.is_removed(e)) || !style.drawn) { continue; }
+
+      float p[3], q[3];
+      position(amesh.source(amesh.halfedge(e)), p);
+      position(amesh.target(amesh.halfedge(e)), q);
+      const int pos=style.colored ? Graphics_scene::POS_COLORED_SEGMENTS : Graphics_scene::POS_MONO_SEGMENTS;
+      block.push_position(pos, p);
+      block.push_position(pos, q);
+      if (style.colored)
+      {
+        block.push_color(Graphics_scene::COLOR_SEGMENTS, style.color);
+        block.push_color(Graphics_scene::COLOR_SEGMENTS, style.color);
+      }
+    }
+
+    const std::size_t lastVertex=drawVertices ? std::min(nbVertices, first+blockSize) : 0;
+    if (first < lastVertex)
+    {
+      internal::element_styles<Vertex_index>(amesh, first, lastVertex, batch.vertex_styles, gs_options.draw_vertex,
+                                             gs_options.colored_vertex, gs_options.vertex_color, styles);
+    }
+    for (std::size_t i=first; i<lastVertex; ++i)
+    {
+      const Vertex_index v(static_cast<typename SM::size_type>(i));
+      const Style& style=styles[i-first];
+      if ((hasGarbage && amesh.is_removed(v)) || !style.drawn) { continue; }
+
+      float p[3];
+      position(v, p);
+      block.push_position(style.colored ? Graphics_scene::POS_COLORED_POINTS : Graphics_scene::POS_MONO_POINTS, p);
+      if (style.colored) { block.push_color(Graphics_scene::COLOR_POINTS, style.color); }
+    }
+  });
+
+  // Blocks appended in order, each copied by one thread
+  std::vector<std::size_t> offsets(blocks.size()*Graphics_scene::LAST_INDEX);
+  for (int a=0; a<Graphics_scene::LAST_INDEX; ++a)
+  {
+    std::vector<float>& array=CGAL::GLFW::Graphics_scene_access::array(graphics_scene, a);
+    std::size_t size=array.size();
+    for (std::size_t b=0; b<blocks.size(); ++b)
+    {
+      offsets[b*Graphics_scene::LAST_INDEX+a]=size;
+      size+=blocks[b].arrays[a].size();
+    }
+    array.resize(size);
+  }
+  CGAL::Bbox_3& bbox=CGAL::GLFW::Graphics_scene_access::bounding_box(graphics_scene);
+  for (const internal::Graphics_scene_block& block : blocks)
+  {
+    if (block.min[0] <= block.max[0])
+    { bbox+=CGAL::Bbox_3(block.min[0], block.min[1], block.min[2], block.max[0], block.max[1], block.max[2]); }
+  }
+  internal::parallel_blocks(blocks.size(), 1, nbThreads, [&](std::size_t b, std::size_t, std::size_t)
+  {
+    for (int a=0; a<Graphics_scene::LAST_INDEX; ++a)
+    {
+      std::vector<float>& source=blocks[b].arrays[a];
+      if (!source.empty())
+      {
+        std::memcpy(CGAL::GLFW::Graphics_scene_access::array(graphics_scene, a).data()+offsets[b*Graphics_scene::LAST_INDEX+a],
+                    source.data(), source.size()*sizeof(float));
+      }
+      std::vector<float>().swap(source);
+    }
+  });
+
+  // Non convex faces
+  for (const internal::Graphics_scene_block& block : blocks)
+  {
+    for (const auto& polygon : block.polygons)
+    {
+      if (polygon.second.colored) { graphics_scene.face_begin(polygon.second.color); }
+      else { graphics_scene.face_begin(); }
+
+      const Halfedge_index h0=amesh.halfedge(Face_index(static_cast<typename SM::size_type>(polygon.first)));
+      Halfedge_index h=h0;
+      do
+      {
+        const float* n=&vertexNormals[3*amesh.source(h).idx()];
+        graphics_scene.add_point_in_face(amesh.point(amesh.source(h)), Vector(n[0], n[1], n[2]));
+        h=amesh.next(h);
+      }
+      while (h != h0);
+      graphics_scene.face_end();
+    }
+  }
+}
+#endif
+
+// In parallel with options giving all their batch callbacks, the per element callbacks of the other ones
+// are called in order by this thread (as all of them without CGAL_GLFW_GRAPHICS_SCENE_ACCESS)
 template<class K,  class GSOptions>
 void add_to_graphics_scene(const Surface_mesh<K>& amesh,
                            CGAL::Graphics_scene &graphics_scene,
                            const GSOptions &gs_options)
-{ add_to_graphics_scene_for_fg(amesh, graphics_scene, gs_options); }
+{
+#if CGAL_GLFW_GRAPHICS_SCENE_ACCESS
+  if (internal::has_batch_callbacks<Surface_mesh<K>>(gs_options))
+  {
+    add_to_graphics_scene_in_parallel(amesh, graphics_scene, gs_options);
+    return;
+  }
+#endif
+  add_to_graphics_scene_for_fg(amesh, graphics_scene, gs_options);
+}
 
 template<class K>
 void add_to_graphics_scene(const Surface_mesh<K>& amesh,
                            CGAL::Graphics_scene &graphics_scene)
-{ add_to_graphics_scene_for_fg(amesh, graphics_scene,
-                               Graphics_scene_options_surface_mesh<K>(amesh)); }
+{ add_to_graphics_scene(amesh, graphics_scene, Graphics_scene_batch_options_surface_mesh<K>(amesh)); }
 
+// Adds the faces of amesh to the level of detail hierarchy lod (faces are triangulated as fans).
+template<class K, class GSOptions>
+void add_to_lod_mesh(const Surface_mesh<K>& amesh,
+                     CGAL::GLFW::Lod_mesh& lod,
+                     const GSOptions &gs_options)
+{
+  using SM = Surface_mesh<K>;
+  if (!gs_options.are_faces_enabled()) { return; }
 
-  // Specialization of draw function.
+  std::vector<float> points;
+  std::vector<std::uint32_t> ids;
+  for (typename SM::Vertex_index v : amesh.vertices())
+  {
+    if (ids.size() <= v.idx()) { ids.resize(v.idx() + 1); }
+    ids[v.idx()] = static_cast<std::uint32_t>(points.size() / 3);
+
+    const auto& p = amesh.point(v);
+    points.push_back(static_cast<float>(CGAL::to_double(p.x())));
+    points.push_back(static_cast<float>(CGAL::to_double(p.y())));
+    points.push_back(static_cast<float>(CGAL::to_double(p.z())));
+  }
+
+  std::vector<std::uint32_t> mono_triangles, colored_triangles;
+  std::vector<float> colors;
+  for (typename SM::Face_index f : amesh.faces())
+  {
+    if (!gs_options.draw_face(amesh, f)) { continue; }
+
+    const bool colored = gs_options.colored_face(amesh, f);
+    std::vector<std::uint32_t>& triangles = colored ? colored_triangles : mono_triangles;
+    CGAL::IO::Color c;
+    if (colored) { c = gs_options.face_color(amesh, f); }
+
+    const typename SM::Halfedge_index h0 = amesh.halfedge(f);
+    for (typename SM::Halfedge_index h = amesh.next(h0); amesh.next(h) != h0; h = amesh.next(h))
+    {
+      triangles.push_back(ids[amesh.target(h0).idx()]);
+      triangles.push_back(ids[amesh.target(h).idx()]);
+      triangles.push_back(ids[amesh.target(amesh.next(h)).idx()]);
+
+      if (colored)
+      {
+        colors.push_back(c.red() / 255.f);
+        colors.push_back(c.green() / 255.f);
+        colors.push_back(c.blue() / 255.f);
+      }
+    }
+  }
+
+  // Normals of all the faces, chunk borders and mono/colored borders are shaded the same on both sides
+  std::vector<float> normals;
+  CGAL::GLFW::Lod_mesh::add_normals(points, mono_triangles, normals);
+  CGAL::GLFW::Lod_mesh::add_normals(points, colored_triangles, normals);
+
+  if (!mono_triangles.empty()) { lod.add_triangles(points, mono_triangles, {}, normals); }
+  if (!colored_triangles.empty()) { lod.add_triangles(points, colored_triangles, colors, normals); }
+}
+
+// Sets mesh to write the faces of amesh straight into the buffers of the viewer (faces are triangulated as fans).
+// Without colored faces, the vertices are the vertices of amesh, otherwise the corners of the triangles. Styles and
+// normals of the faces are computed here by nbThreads threads (0: one per core, a single one for options without
+// batch callbacks), positions and vertex normals when the viewer writes the buffers. amesh must not change until then.
+template<class K, class GSOptions>
+void make_direct_mesh(const Surface_mesh<K>& amesh,
+                      CGAL::GLFW::Direct_mesh& mesh,
+                      const GSOptions &gs_options,
+                      unsigned nbThreads=0)
+{
+  using SM = Surface_mesh<K>;
+  using Style = Graphics_scene_element_style;
+  using Vertex_index = typename SM::Vertex_index;
+  using Face_index = typename SM::Face_index;
+  using Halfedge_index = typename SM::Halfedge_index;
+
+  static const std::size_t blockSize=1 << 16;
+  if (nbThreads == 0) { nbThreads=std::max(1u, std::thread::hardware_concurrency()); }
+
+  mesh=CGAL::GLFW::Direct_mesh();
+  if (!gs_options.are_faces_enabled()) { return; }
+
+  // Styles, and triangles of each block
+  struct State
+  {
+    std::vector<Style> styles;
+    std::vector<float> normals;                             // Newell normal of each face, normalized
+    std::vector<std::size_t> mono_offsets, colored_offsets; // first triangle of each block
+    std::size_t nb_mono=0;
+    bool corners=false;
+  };
+  auto state=std::make_shared<State>();
+  const std::size_t nbFaces=amesh.num_faces();
+  const std::size_t nbBlocks=(std::max<std::size_t>(nbFaces, amesh.num_vertices())+blockSize-1)/blockSize;
+  const bool hasGarbage=amesh.has_garbage();
+  const Graphics_scene_batch_callbacks<SM>& batch=internal::batch_callbacks<SM>(gs_options);
+
+  state->styles.resize(nbFaces);
+  state->normals.resize(3*nbFaces, 0.f);
+  std::vector<std::size_t> nbMono(nbBlocks, 0), nbColored(nbBlocks, 0);
+  std::vector<Eigen::AlignedBox3f> boxes(nbBlocks);
+  const unsigned styleThreads=batch.face_styles ? nbThreads : 1; // per element callbacks may not be thread safe
+  internal::parallel_blocks(nbFaces, blockSize, styleThreads, [&](std::size_t b, std::size_t first, std::size_t last)
+  {
+    std::vector<Style> styles;
+    internal::element_styles<Face_index>(amesh, first, last, batch.face_styles, gs_options.draw_face,
+                                         gs_options.colored_face, gs_options.face_color, styles);
+    for (std::size_t i=first; i<last; ++i)
+    {
+      const Face_index f(static_cast<typename SM::size_type>(i));
+      Style& style=state->styles[i]=styles[i-first];
+      if (hasGarbage && amesh.is_removed(f)) { style.drawn=false; }
+      if (!style.drawn) { continue; }
+
+      std::size_t degree=0;
+      double n[3]={0, 0, 0};
+      const Halfedge_index h0=amesh.halfedge(f);
+      Halfedge_index h=h0;
+      do
+      {
+        const auto& ps=amesh.point(amesh.source(h));
+        const auto& pt=amesh.point(amesh.target(h));
+        const float p[3]={static_cast<float>(CGAL::to_double(ps.x())), static_cast<float>(CGAL::to_double(ps.y())),
+                          static_cast<float>(CGAL::to_double(ps.z()))};
+        const float q[3]={static_cast<float>(CGAL::to_double(pt.x())), static_cast<float>(CGAL::to_double(pt.y())),
+                          static_cast<float>(CGAL::to_double(pt.z()))};
+        boxes[b].extend(Eigen::Vector3f(p[0], p[1], p[2]));
+        n[0]+=(double(p[1])-q[1])*(double(p[2])+q[2]);
+        n[1]+=(double(p[2])-q[2])*(double(p[0])+q[0]);
+        n[2]+=(double(p[0])-q[0])*(double(p[1])+q[1]);
+        ++degree;
+        h=amesh.next(h);
+      }
+      while (h != h0);
+      if (degree >= 3) { (style.colored ? nbColored : nbMono)[b]+=degree-2; }
+
+      const double length=std::sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+      if (length > 0) { for (int k=0; k<3; ++k) { state->normals[3*i+k]=static_cast<float>(n[k]/length); } }
+    }
+  });
+
+  state->mono_offsets.resize(nbBlocks);
+  state->colored_offsets.resize(nbBlocks);
+  for (std::size_t b=0; b<nbBlocks; ++b)
+  {
+    state->mono_offsets[b]=mesh.nb_mono_triangles;
+    mesh.nb_mono_triangles+=nbMono[b];
+    mesh.box.extend(boxes[b]);
+  }
+  mesh.nb_triangles=mesh.nb_mono_triangles;
+  for (std::size_t b=0; b<nbBlocks; ++b)
+  {
+    state->colored_offsets[b]=mesh.nb_triangles;
+    mesh.nb_triangles+=nbColored[b];
+  }
+  state->nb_mono=mesh.nb_mono_triangles;
+  state->corners=mesh.colored();
+  mesh.nb_vertices=state->corners ? 3*mesh.nb_triangles : amesh.num_vertices();
+  mesh.nb_blocks=nbBlocks;
+
+  mesh.write_block=[&amesh, state, hasGarbage](std::size_t b, float* vertices, std::uint32_t* indices)
+  {
+    const std::size_t floats=state->corners ? 9 : 6;
+    auto position=[&](Vertex_index v, float* p)
+    {
+      const auto& point=amesh.point(v);
+      p[0]=static_cast<float>(CGAL::to_double(point.x()));
+      p[1]=static_cast<float>(CGAL::to_double(point.y()));
+      p[2]=static_cast<float>(CGAL::to_double(point.z()));
+    };
+    // Average of the Newell normals of the faces around v (as add_to_graphics_scene_in_parallel)
+    auto normal=[&](Vertex_index v, float* out)
+    {
+      double n[3]={0, 0, 0};
+      for (Halfedge_index hv : CGAL::halfedges_around_target(amesh.halfedge(v), amesh))
+      {
+        if (amesh.is_border(hv)) { continue; }
+        const float* fn=&state->normals[3*amesh.face(hv).idx()];
+        for (int k=0; k<3; ++k) { n[k]+=fn[k]; }
+      }
+      const double length=std::sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+      for (int k=0; k<3; ++k) { out[k]=length>0 ? static_cast<float>(n[k]/length) : 0.f; }
+    };
+    auto write_vertex=[&](Vertex_index v, float* out)
+    {
+      position(v, out);
+      if (amesh.halfedge(v) != SM::null_halfedge()) { normal(v, out+3); }
+      else { out[3]=out[4]=out[5]=0.f; }
+    };
+
+    // Vertices of the mesh, in their order
+    if (!state->corners)
+    {
+      const std::size_t last=std::min<std::size_t>(amesh.num_vertices(), (b+1)*blockSize);
+      for (std::size_t i=b*blockSize; i<last; ++i)
+      {
+        const Vertex_index v(static_cast<typename SM::size_type>(i));
+        if (hasGarbage && amesh.is_removed(v)) { std::fill(vertices+floats*i, vertices+floats*(i+1), 0.f); }
+        else { write_vertex(v, vertices+floats*i); }
+      }
+    }
+
+    // Fans of the faces, same first vertex as add_to_graphics_scene_in_parallel
+    std::size_t mono=state->mono_offsets[b], colored=state->colored_offsets[b];
+    const std::size_t last=std::min(state->styles.size(), (b+1)*blockSize);
+    for (std::size_t i=b*blockSize; i<last; ++i)
+    {
+      const Style& style=state->styles[i];
+      if (!style.drawn) { continue; }
+
+      const Halfedge_index h0=amesh.halfedge(Face_index(static_cast<typename SM::size_type>(i)));
+      const Vertex_index v0=amesh.source(h0);
+      for (Halfedge_index h=amesh.next(h0); amesh.next(h) != h0; h=amesh.next(h))
+      {
+        std::size_t& t=style.colored ? colored : mono;
+        const Vertex_index corners[3]={v0, amesh.source(h), amesh.target(h)};
+        for (int k=0; k<3; ++k)
+        {
+          if (!state->corners)
+          {
+            indices[3*t+k]=static_cast<std::uint32_t>(corners[k].idx());
+            continue;
+          }
+
+          float* out=vertices+floats*(3*t+k);
+          write_vertex(corners[k], out);
+          out[6]=style.colored ? style.color.red()/255.f : 0.f;
+          out[7]=style.colored ? style.color.green()/255.f : 0.f;
+          out[8]=style.colored ? style.color.blue()/255.f : 0.f;
+          indices[3*t+k]=static_cast<std::uint32_t>(3*t+k);
+        }
+        ++t;
+      }
+    }
+  };
+}
+
+namespace internal {
+
+// Fills scene, lod and direct with amesh for draw(): large meshes are drawn with levels of detail, the faces of the
+// smaller large meshes are written straight into the buffers of the viewer, without the scene (a direct mesh is not
+// drawn along with levels of detail). Returns true if the faces were left out of scene for the levels of detail:
+// add_faces_to_graphics_scene adds them if the viewer cannot draw the levels of detail (see lod_fallback_faces).
+template<class K, class GSOptions>
+bool add_to_viewer_meshes(const Surface_mesh<K>& amesh,
+                          CGAL::Graphics_scene& scene,
+                          CGAL::GLFW::Lod_mesh& lod,
+                          CGAL::GLFW::Direct_mesh& direct,
+                          const GSOptions& gs_options)
+{
+  if (!gs_options.are_faces_enabled())
+  {
+    add_to_graphics_scene(amesh, scene, gs_options);
+    return false;
+  }
+
+  const bool useLod=amesh.number_of_faces() >= LOD_MIN_FACES;
+#if !CGAL_GLFW_GRAPHICS_SCENE_ACCESS
+  // The bounding box of the scene cannot cover faces it does not have: they stay in the scene (drawn when the
+  // levels of detail are not), without direct mesh
+  static_cast<void>(direct);
+  if (useLod) { add_to_lod_mesh(amesh, lod, gs_options); }
+  add_to_graphics_scene(amesh, scene, gs_options);
+  return false;
+#else
+  if (!useLod && amesh.number_of_faces() < DIRECT_MESH_MIN_FACES)
+  {
+    add_to_graphics_scene(amesh, scene, gs_options);
+    return false;
+  }
+
+  // The bounding box of the scene also covers the faces it does not have
+  Eigen::AlignedBox3f box;
+  if (useLod)
+  {
+    add_to_lod_mesh(amesh, lod, gs_options);
+    const CGAL::Bbox_3 meshBox=CGAL::Polygon_mesh_processing::bbox(amesh);
+    box.extend(Eigen::Vector3f(meshBox.xmin(), meshBox.ymin(), meshBox.zmin()));
+    box.extend(Eigen::Vector3f(meshBox.xmax(), meshBox.ymax(), meshBox.zmax()));
+  }
+  else
+  {
+    make_direct_mesh(amesh, direct, gs_options);
+    box=direct.box;
+  }
+
+  GSOptions edges_and_vertices(gs_options);
+  edges_and_vertices.disable_faces();
+  add_to_graphics_scene(amesh, scene, edges_and_vertices);
+
+  if (!box.isEmpty())
+  {
+    CGAL::GLFW::Graphics_scene_access::bounding_box(scene)+=
+      CGAL::Bbox_3(box.min().x(), box.min().y(), box.min().z(), box.max().x(), box.max().y(), box.max().z());
+  }
+  return useLod;
+#endif
+}
+
+template<class K, class GSOptions>
+void add_faces_to_graphics_scene(const Surface_mesh<K>& amesh,
+                                 CGAL::Graphics_scene& scene,
+                                 const GSOptions& gs_options)
+{
+  GSOptions faces(gs_options);
+  faces.disable_vertices();
+  faces.disable_edges();
+  add_to_graphics_scene(amesh, scene, faces);
+}
+
+// Elements read since the previous chunk (nbPoints points and nbPolygons polygons were sent): the new vertices
+// as points, then the new polygons whose vertices are read, as fans with their Newell normal (also used as
+// smooth normal, the other faces of their vertices are not known yet). Returns false if there is none.
+inline bool next_stream_chunk(const CGAL::GLFW::Polygon_file_reader& reader,
+                              std::size_t& nbPoints, std::size_t& nbPolygons,
+                              CGAL::GLFW::Scene_stream::Chunk& chunk)
+{
+  const std::vector<double>& points=reader.points();
+  const std::vector<std::uint32_t>& polygonVertices=reader.polygon_vertices();
+  const std::vector<std::size_t>& offsets=reader.polygon_offsets();
+  const std::size_t firstPoint=nbPoints, firstPolygon=nbPolygons;
+
+  auto position=[&](std::size_t v, float* p)
+  { for (int k=0; k<3; ++k) { p[k]=static_cast<float>(points[3*v+k]); } };
+
+  std::vector<float>& pointPositions=chunk.arrays[Graphics_scene::POS_MONO_POINTS];
+  pointPositions.resize(points.size()-3*nbPoints);
+  for (; 3*nbPoints<points.size(); ++nbPoints)
+  {
+    float* p=&pointPositions[3*(nbPoints-firstPoint)];
+    position(nbPoints, p);
+    chunk.box.extend(Eigen::Vector3f(p[0], p[1], p[2]));
+  }
+
+  std::vector<float>& facePositions=chunk.arrays[Graphics_scene::POS_MONO_FACES];
+  std::vector<float>& flatNormals=chunk.arrays[Graphics_scene::FLAT_NORMAL_MONO_FACES];
+  std::vector<float>& smoothNormals=chunk.arrays[Graphics_scene::SMOOTH_NORMAL_MONO_FACES];
+  std::vector<float> corners;
+  for (; nbPolygons+1<offsets.size(); ++nbPolygons)
+  {
+    const std::size_t first=offsets[nbPolygons], last=offsets[nbPolygons+1];
+    if (last-first < 3) { continue; }
+
+    bool read=true;
+    for (std::size_t i=first; i<last && read; ++i) { read=3*std::size_t(polygonVertices[i])<points.size(); }
+    if (!read) { break; }
+
+    corners.resize(3*(last-first));
+    double n[3]={0, 0, 0};
+    for (std::size_t i=first; i<last; ++i) { position(polygonVertices[i], &corners[3*(i-first)]); }
+    for (std::size_t i=0; i<last-first; ++i)
+    {
+      const float* p=&corners[3*i];
+      const float* q=&corners[3*((i+1)%(last-first))];
+      n[0]+=(double(p[1])-q[1])*(double(p[2])+q[2]);
+      n[1]+=(double(p[2])-q[2])*(double(p[0])+q[0]);
+      n[2]+=(double(p[0])-q[0])*(double(p[1])+q[1]);
+    }
+    const double length=std::sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+    float normal[3];
+    for (int k=0; k<3; ++k) { normal[k]=length>0 ? static_cast<float>(n[k]/length) : 0.f; }
+
+    for (std::size_t k=1; k+1<last-first; ++k)
+    {
+      for (std::size_t corner : {std::size_t(0), k, k+1})
+      {
+        facePositions.insert(facePositions.end(), &corners[3*corner], &corners[3*corner]+3);
+        flatNormals.insert(flatNormals.end(), normal, normal+3);
+        smoothNormals.insert(smoothNormals.end(), normal, normal+3);
+      }
+    }
+  }
+  return nbPoints > firstPoint || nbPolygons > firstPolygon;
+}
+
+// amesh built from the polygons of reader like CGAL::IO::read_polygon_mesh does: as they are if they form a
+// polygon mesh, otherwise after they are repaired and oriented
 template<class K>
-void draw(const Surface_mesh<K>& amesh,
-          const char* title="Surface_mesh Basic Viewer")
+bool polygon_soup_to_surface_mesh(CGAL::GLFW::Polygon_file_reader& reader, Surface_mesh<K>& amesh)
 {
-  CGAL::Graphics_scene buffer;
-  add_to_graphics_scene(amesh, buffer);
-  CGAL::GLFW::draw_graphics_scene(buffer, title);
+  namespace PMP = CGAL::Polygon_mesh_processing;
+  using Point = typename Surface_mesh<K>::Point;
+
+  std::vector<Point> points;
+  points.reserve(reader.points().size()/3);
+  for (std::size_t i=0; i<reader.points().size(); i+=3)
+  { points.emplace_back(reader.points()[i], reader.points()[i+1], reader.points()[i+2]); }
+
+  std::vector<std::vector<std::size_t>> polygons(reader.polygon_offsets().size()-1);
+  for (std::size_t f=0; f<polygons.size(); ++f)
+  {
+    polygons[f].assign(reader.polygon_vertices().begin()+reader.polygon_offsets()[f],
+                       reader.polygon_vertices().begin()+reader.polygon_offsets()[f+1]);
+  }
+  reader.clear();
+
+  if (!PMP::is_polygon_soup_a_polygon_mesh(polygons))
+  {
+    PMP::repair_polygon_soup(points, polygons);
+    PMP::orient_polygon_soup(points, polygons);
+    if (!PMP::is_polygon_soup_a_polygon_mesh(polygons)) { return false; }
+  }
+
+  amesh.clear();
+  PMP::polygon_soup_to_polygon_mesh(points, polygons, amesh);
+  return true;
+}
+
+} // namespace internal
+
+/*
+ * Opens the viewer before amesh is read from filename (ASCII OFF or PLY) by a background thread. The file is parsed
+ * STREAM_CHUNK_BYTES at a time and the vertices (as points) and faces (flat shaded fans) read so far are drawn
+ * as they arrive. Once the file is read, amesh is built from its polygons as CGAL::IO::read_polygon_mesh does,
+ * then the scene is replaced by the one draw() would show with the options returned by make_options(amesh) (levels
+ * of detail or direct mesh for large meshes), also on the background thread. make_options may add properties to
+ * amesh, the options it returns are not copied (their callbacks may refer to them).
+ * Other files (OBJ, STL, binary OFF...) are read by CGAL::IO::read_polygon_mesh then drawn by draw(), and
+ * files with a part the reader does not support are read again by it at the end.
+ * Returns false if the file could not be read (or the viewer was closed before), without opening the viewer
+ * if its header could not be read.
+ */
+template<class K, class MakeOptions>
+bool draw_streamed(const std::string& filename,
+                   Surface_mesh<K>& amesh,
+                   const MakeOptions& make_options,
+                   const char* title="Surface_mesh Basic Viewer")
+{
+  using GSOptions=std::decay_t<decltype(make_options(amesh))>;
+  struct Options
+  {
+    Options(const MakeOptions& make_options, Surface_mesh<K>& amesh) : gs_options(make_options(amesh)) {}
+    GSOptions gs_options;
+  };
+
+  CGAL::GLFW::Polygon_file_reader reader;
+  if (!CGAL::GLFW::Polygon_file_reader::is_supported(filename) || !reader.open(filename))
+  {
+    if (!CGAL::IO::read_polygon_mesh(filename, amesh)) { return false; }
+
+    Options options(make_options, amesh);
+    draw(amesh, options.gs_options, title);
+    return true;
+  }
+
+  // Filled by the loader, they outlive the viewer
+  std::unique_ptr<Options> options;
+  CGAL::GLFW::Lod_mesh lod;
+  CGAL::GLFW::Direct_mesh direct;
+
+  CGAL::Graphics_scene scene;
+  CGAL::GLFW::Scene_stream stream;
+  bool read=false;
+  std::thread loader([&]()
+  {
+    std::size_t nbPoints=0, nbPolygons=0;
+    for (bool more=true; more && !stream.cancelled();)
+    {
+      more=reader.read(STREAM_CHUNK_BYTES);
+      CGAL::GLFW::Scene_stream::Chunk chunk;
+      if (internal::next_stream_chunk(reader, nbPoints, nbPolygons, chunk)) { stream.append(std::move(chunk)); }
+    }
+
+    if (!stream.cancelled())
+    {
+      // A part of the file the reader does not support: it is read again by CGAL
+      read=reader.failed() ? CGAL::IO::read_polygon_mesh(filename, amesh)
+                           : internal::polygon_soup_to_surface_mesh(reader, amesh);
+      if (read && !stream.cancelled())
+      {
+        options=std::make_unique<Options>(make_options, amesh);
+        CGAL::GLFW::Scene_stream::Replacement replacement;
+        replacement.scene=std::make_shared<CGAL::Graphics_scene>();
+        if (internal::add_to_viewer_meshes(amesh, *replacement.scene, lod, direct, options->gs_options))
+        {
+          CGAL::Graphics_scene* complete=replacement.scene.get();
+          const GSOptions* gs_options=&options->gs_options;
+          replacement.lod=&lod;
+          replacement.lod_fallback_faces=[&amesh, complete, gs_options]()
+          { internal::add_faces_to_graphics_scene(amesh, *complete, *gs_options); };
+        }
+        else if (direct.nb_triangles > 0)
+        { replacement.direct=&direct; }
+        stream.replace(std::move(replacement));
+      }
+    }
+    stream.finish();
+  });
+
+  CGAL::GLFW::Basic_Viewer viewer(&scene, title);
+  viewer.scene_stream(&stream, &scene);
+  viewer.show();
+
+  stream.cancel();
+  loader.join();
+  return read;
 }
 
+  // Specialization of draw function.
 template<class K, class GSOptions>
 void draw(const Surface_mesh<K>& amesh,
           const GSOptions &gs_options,
           const char* title="Surface_mesh Basic Viewer")
 {
   CGAL::Graphics_scene buffer;
-  add_to_graphics_scene(amesh, buffer, gs_options);
-  CGAL::GLFW::draw_graphics_scene(buffer, title);
+  CGAL::GLFW::Lod_mesh lod;
+  CGAL::GLFW::Direct_mesh direct;
+  const bool lodFaces=internal::add_to_viewer_meshes(amesh, buffer, lod, direct, gs_options);
+
+  CGAL::GLFW::Basic_Viewer viewer(&buffer, title);
+  viewer.lod_mesh(&lod);
+  viewer.direct_mesh(&direct);
+  if (lodFaces)
+  { viewer.lod_fallback_faces([&]() { internal::add_faces_to_graphics_scene(amesh, buffer, gs_options); }); }
+  viewer.show();
+}
+
+template<class K>
+void draw(const Surface_mesh<K>& amesh,
+          const char* title="Surface_mesh Basic Viewer")
+{
+  Graphics_scene_batch_options_surface_mesh<K> gs_options(amesh);
+  draw(amesh, gs_options, title);
 }
 
 
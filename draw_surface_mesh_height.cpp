@@ -55,14 +55,13 @@ int main(int argc, char* argv[])
 {
   const std::string filename = (argc>1) ? CGAL::data_file_path(argv[1]) : CGAL::data_file_path("meshes/elephant.off");
 
+  // OFF and PLY meshes are drawn while the file is read, other formats once they are read
   Mesh sm;
-  if(!CGAL::IO::read_polygon_mesh(filename, sm))
+  if(!CGAL::draw_streamed(filename, sm, [](Mesh& sm) { return Colored_faces_given_height(sm); }))
   {
     std::cerr << "Invalid input file: " << filename << std::endl;
     return EXIT_FAILURE;
   }
 
-  CGAL::draw(sm, Colored_faces_given_height(sm));
-
   return EXIT_SUCCESS;
 }
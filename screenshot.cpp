@@ -7,6 +7,8 @@
 #include <CGAL/Graphics_scene_options.h>
 #include "GLFW/Basic_viewer_impl.h"
 
+#include <cstdlib>
+#include <string>
 #include <vector>
 #include <iostream>
 
@@ -32,13 +34,23 @@ struct Graphics_scene_options_green_points :
     }
 };
 
+// Usage: screenshot [file] [--turntable views] [--poster size]
 int main(int argc, char** argv)
 {
     std::vector<Pwn> points;
 
     std::string filepath = "points_3/kitten.xyz";
-    if (argc > 1) {
-        filepath = argv[1];
+    int nbViews = 0;    // turntable images, none by default
+    int posterSize = 0; // width and height of the poster, none by default
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--turntable" && i + 1 < argc) {
+            nbViews = std::atoi(argv[++i]);
+        } else if (arg == "--poster" && i + 1 < argc) {
+            posterSize = std::atoi(argv[++i]);
+        } else {
+            filepath = arg;
+        }
     }
 
     if (!CGAL::IO::read_points(CGAL::data_file_path(filepath), std::back_inserter(points),
@@ -73,9 +85,26 @@ int main(int argc, char** argv)
         CGAL::add_to_graphics_scene(output_mesh, scene);
 
         auto viewer = CGAL::GLFW::Basic_Viewer(&scene);
-        // TODO faire un exemple plus complexe
         viewer.position({ 0, 0, -50 });
         viewer.make_screenshot("test.png");
+
+        // Turntable: all the views are rendered with one context and one upload of the scene
+        if (nbViews > 0)
+        {
+            std::vector<CGAL::GLFW::Viewer_view> views(nbViews, viewer.current_view());
+            for (int i = 0; i < nbViews; ++i)
+            {
+                views[i].scene_rotation = eulerAngleXY(0.f, 2 * CGAL_PI * i / nbViews);
+                views[i].path = "turntable_" + std::to_string(i) + ".png";
+            }
+            viewer.render_views(views);
+        }
+
+        // posterSize x posterSize, 2x2 samples per pixel, rendered in tiles
+        if (posterSize > 0)
+        {
+            viewer.make_poster("poster.png", posterSize, posterSize, 2);
+        }
     }
     else
     {